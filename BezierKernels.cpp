@@ -0,0 +1,223 @@
+// ==========================================================================
+// Batched Bezier Evaluation Kernels
+//
+// See BezierKernels.h. Each kernel handles one coordinate (x or y) of a
+// batch at a time: it loads the control values of as many segments as it
+// has lanes, forms the power-basis forward differences for the step size
+// h = 1 / steps and then emits one point per step with additions only.
+// The last point is the segment's end point itself, so the round-off of
+// the differences never separates consecutive segments.
+//
+// For a cubic P(u) = a u^3 + b u^2 + c u + d:
+//     a = -p0 + 3 p1 - 3 p2 + p3,  b = 3 p0 - 6 p1 + 3 p2,  c = 3 (p1 - p0)
+//     f = d,  df = a h^3 + b h^2 + c h,  d2f = 6 a h^3 + 2 b h^2,  d3f = 6 a h^3
+// and for a quadratic P(u) = a u^2 + b u + c:
+//     a = p0 - 2 p1 + p2,  b = 2 (p1 - p0)
+//     f = c,  df = a h^2 + b h,  d2f = 2 a h^2
+// ==========================================================================
+
+#include "BezierKernels.h"
+
+#ifdef BEZIER_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+void BezierSoA::Clear()
+{
+    for (int i = 0; i < 4; ++i) {
+        x[i].clear();
+        y[i].clear();
+    }
+}
+
+void BezierSoA::Append(const float *points)
+{
+    for (int i = 0; i <= degree; ++i) {
+        x[i].push_back(points[2*i]);
+        y[i].push_back(points[2*i + 1]);
+    }
+}
+
+void BezierSoA::AppendPatches(const float *vertices, size_t count)
+{
+    for (size_t i = 0; i + 4 <= count; i += 4)
+        Append(vertices + 2 * i);
+}
+
+// --------------------------------------------------------------------------
+// one coordinate of segments [begin, end) of a batch, one at a time
+
+static void EvaluateScalar(const float *const p[4], int degree, size_t begin, size_t end,
+                           size_t count, int steps, float *out)
+{
+    float h = 1.f / steps;
+    for (size_t i = begin; i < end; ++i)
+    {
+        float f, df, d2f, d3f = 0.f;
+        if (degree == 3) {
+            float a = -p[0][i] + 3.f * p[1][i] - 3.f * p[2][i] + p[3][i];
+            float b = 3.f * p[0][i] - 6.f * p[1][i] + 3.f * p[2][i];
+            float c = 3.f * (p[1][i] - p[0][i]);
+            f = p[0][i];
+            df = ((a * h + b) * h + c) * h;
+            d2f = (6.f * a * h + 2.f * b) * h * h;
+            d3f = 6.f * a * h * h * h;
+        }
+        else {
+            float a = p[0][i] - 2.f * p[1][i] + p[2][i];
+            float b = 2.f * (p[1][i] - p[0][i]);
+            f = p[0][i];
+            df = (a * h + b) * h;
+            d2f = 2.f * a * h * h;
+        }
+
+        for (int k = 0; k < steps; ++k) {
+            out[k * count + i] = f;
+            f += df;
+            df += d2f;
+            d2f += d3f;
+        }
+        out[steps * count + i] = p[degree][i];
+    }
+}
+
+#ifdef BEZIER_X86_KERNELS
+
+__attribute__((target("sse2")))
+static size_t EvaluateSSE2(const float *const p[4], int degree, size_t count, int steps, float *out)
+{
+    const __m128 h = _mm_set1_ps(1.f / steps);
+    const __m128 two = _mm_set1_ps(2.f), three = _mm_set1_ps(3.f), six = _mm_set1_ps(6.f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 p0 = _mm_loadu_ps(p[0] + i), p1 = _mm_loadu_ps(p[1] + i), p2 = _mm_loadu_ps(p[2] + i);
+        __m128 f = p0, df, d2f, d3f = _mm_setzero_ps();
+        if (degree == 3) {
+            __m128 p3 = _mm_loadu_ps(p[3] + i);
+            __m128 a = _mm_add_ps(_mm_sub_ps(p3, p0), _mm_mul_ps(three, _mm_sub_ps(p1, p2)));
+            __m128 b = _mm_mul_ps(three, _mm_add_ps(_mm_sub_ps(p0, _mm_mul_ps(two, p1)), p2));
+            __m128 c = _mm_mul_ps(three, _mm_sub_ps(p1, p0));
+            __m128 h2 = _mm_mul_ps(h, h);
+            df = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, h), b), h), c), h);
+            d2f = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(six, a), h), _mm_mul_ps(two, b)), h2);
+            d3f = _mm_mul_ps(_mm_mul_ps(six, a), _mm_mul_ps(h2, h));
+        }
+        else {
+            __m128 a = _mm_add_ps(_mm_sub_ps(p0, _mm_mul_ps(two, p1)), p2);
+            __m128 b = _mm_mul_ps(two, _mm_sub_ps(p1, p0));
+            df = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, h), b), h);
+            d2f = _mm_mul_ps(_mm_mul_ps(two, a), _mm_mul_ps(h, h));
+        }
+
+        for (int k = 0; k < steps; ++k) {
+            _mm_storeu_ps(out + k * count + i, f);
+            f = _mm_add_ps(f, df);
+            df = _mm_add_ps(df, d2f);
+            d2f = _mm_add_ps(d2f, d3f);
+        }
+        _mm_storeu_ps(out + steps * count + i, _mm_loadu_ps(p[degree] + i));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t EvaluateAVX2(const float *const p[4], int degree, size_t count, int steps, float *out)
+{
+    const __m256 h = _mm256_set1_ps(1.f / steps);
+    const __m256 two = _mm256_set1_ps(2.f), three = _mm256_set1_ps(3.f), six = _mm256_set1_ps(6.f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 p0 = _mm256_loadu_ps(p[0] + i), p1 = _mm256_loadu_ps(p[1] + i);
+        __m256 p2 = _mm256_loadu_ps(p[2] + i);
+        __m256 f = p0, df, d2f, d3f = _mm256_setzero_ps();
+        if (degree == 3) {
+            __m256 p3 = _mm256_loadu_ps(p[3] + i);
+            __m256 a = _mm256_add_ps(_mm256_sub_ps(p3, p0), _mm256_mul_ps(three, _mm256_sub_ps(p1, p2)));
+            __m256 b = _mm256_mul_ps(three, _mm256_add_ps(_mm256_sub_ps(p0, _mm256_mul_ps(two, p1)), p2));
+            __m256 c = _mm256_mul_ps(three, _mm256_sub_ps(p1, p0));
+            __m256 h2 = _mm256_mul_ps(h, h);
+            df = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a, h), b), h), c), h);
+            d2f = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(six, a), h), _mm256_mul_ps(two, b)), h2);
+            d3f = _mm256_mul_ps(_mm256_mul_ps(six, a), _mm256_mul_ps(h2, h));
+        }
+        else {
+            __m256 a = _mm256_add_ps(_mm256_sub_ps(p0, _mm256_mul_ps(two, p1)), p2);
+            __m256 b = _mm256_mul_ps(two, _mm256_sub_ps(p1, p0));
+            df = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a, h), b), h);
+            d2f = _mm256_mul_ps(_mm256_mul_ps(two, a), _mm256_mul_ps(h, h));
+        }
+
+        for (int k = 0; k < steps; ++k) {
+            _mm256_storeu_ps(out + k * count + i, f);
+            f = _mm256_add_ps(f, df);
+            df = _mm256_add_ps(df, d2f);
+            d2f = _mm256_add_ps(d2f, d3f);
+        }
+        _mm256_storeu_ps(out + steps * count + i, _mm256_loadu_ps(p[degree] + i));
+    }
+    return i;
+}
+
+#endif // BEZIER_X86_KERNELS
+
+// --------------------------------------------------------------------------
+
+bool BezierKernels::Supported(BezierISA isa)
+{
+#ifdef BEZIER_X86_KERNELS
+    if (isa == BEZIER_SSE2) return __builtin_cpu_supports("sse2");
+    if (isa == BEZIER_AVX2) return __builtin_cpu_supports("avx2");
+#endif
+    return isa == BEZIER_SCALAR;
+}
+
+BezierISA BezierKernels::Best()
+{
+    static const BezierISA best = Supported(BEZIER_AVX2) ? BEZIER_AVX2
+                                : Supported(BEZIER_SSE2) ? BEZIER_SSE2 : BEZIER_SCALAR;
+    return best;
+}
+
+const char *BezierKernels::Name(BezierISA isa)
+{
+    return isa == BEZIER_AVX2 ? "AVX2" : isa == BEZIER_SSE2 ? "SSE2" : "scalar";
+}
+
+void BezierKernels::Evaluate(const BezierSoA &segments, int steps, float *outX, float *outY,
+                             BezierISA isa)
+{
+    size_t count = segments.Count();
+    if (count == 0 || steps < 1) return;
+    if (!Supported(isa)) isa = BEZIER_SCALAR;
+
+    const float *const px[4] = { segments.x[0].data(), segments.x[1].data(),
+                                 segments.x[2].data(), segments.x[3].data() };
+    const float *const py[4] = { segments.y[0].data(), segments.y[1].data(),
+                                 segments.y[2].data(), segments.y[3].data() };
+
+    // the vector kernels cover whole groups of lanes and report where they
+    // stopped; the scalar loop finishes the remainder
+    size_t done = 0;
+#ifdef BEZIER_X86_KERNELS
+    if (isa == BEZIER_AVX2) {
+        done = EvaluateAVX2(px, segments.degree, count, steps, outX);
+        EvaluateAVX2(py, segments.degree, count, steps, outY);
+    }
+    else if (isa == BEZIER_SSE2) {
+        done = EvaluateSSE2(px, segments.degree, count, steps, outX);
+        EvaluateSSE2(py, segments.degree, count, steps, outY);
+    }
+#endif
+    EvaluateScalar(px, segments.degree, done, count, count, steps, outX);
+    EvaluateScalar(py, segments.degree, done, count, count, steps, outY);
+}
+
+// --------------------------------------------------------------------------
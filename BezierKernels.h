@@ -0,0 +1,67 @@
+// ==========================================================================
+// Batched Bezier Evaluation Kernels
+//
+// Evaluates many quadratic or cubic segments at the same uniform parameter
+// values u = k / steps, k = 0..steps, for flattening, bounds and hit tests
+// on the CPU. Segments are held as a structure of arrays (one array per
+// control point coordinate) so that a SIMD lane processes one segment, and
+// each lane walks its curve by forward differencing: after converting the
+// control points to power-basis coefficients, every further point costs
+// only additions.
+//
+// SSE2 (4 lanes) and AVX2 (8 lanes) versions are compiled with per-function
+// target attributes and picked at run time from the CPU's features; other
+// compilers and architectures use the scalar version.
+// ==========================================================================
+#ifndef BEZIERKERNELS_H
+#define BEZIERKERNELS_H
+
+#include <cstddef>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define BEZIER_X86_KERNELS
+#endif
+
+// segments of one degree, one array per control point coordinate
+struct BezierSoA
+{
+    int                 degree;     // 2 or 3
+    std::vector<float>  x[4];
+    std::vector<float>  y[4];
+
+    explicit BezierSoA(int degree = 3) : degree(degree)
+    {}
+
+    size_t Count() const            { return x[0].size(); }
+    void Clear();
+
+    // appends one segment from (degree + 1) interleaved (x, y) points
+    void Append(const float *points);
+
+    // appends every patch of a GlyphGeometry curve stream (4 vertices per
+    // patch, of which the first degree + 1 are used)
+    void AppendPatches(const float *vertices, size_t count);
+};
+
+enum BezierISA { BEZIER_SCALAR, BEZIER_SSE2, BEZIER_AVX2 };
+
+class BezierKernels
+{
+public:
+    // instruction sets the running CPU supports, and the fastest of them
+    static bool Supported(BezierISA isa);
+    static BezierISA Best();
+    static const char *Name(BezierISA isa);
+
+    // evaluates every segment at u = k / steps for k = 0..steps (steps >= 1),
+    // writing point k of segment i to outX/outY[k * Count() + i]; the output
+    // arrays must hold (steps + 1) * Count() floats each
+    static void Evaluate(const BezierSoA &segments, int steps, float *outX, float *outY,
+                         BezierISA isa);
+    static void Evaluate(const BezierSoA &segments, int steps, float *outX, float *outY)
+    { Evaluate(segments, steps, outX, outY, Best()); }
+};
+
+// --------------------------------------------------------------------------
+#endif // BEZIERKERNELS_H
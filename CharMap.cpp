@@ -0,0 +1,49 @@
+// ==========================================================================
+// Flat Character-to-Glyph Lookup
+//
+// FT_Get_Char_Index walks the font's cmap subtable (a segment search for
+// format 4, a group search for format 12) on every call. A CharMap reads the
+// face's selected charmap once and stores it as a two-level page table over
+// the Unicode range: a directory of 0x1100 page numbers, one per block of 256
+// code points, and the pages themselves, with every empty block sharing page
+// zero. A lookup is then two array reads.
+// ==========================================================================
+
+#include "CharMap.h"
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+bool CharMap::Build(FT_Face face)
+{
+    m_built = false;
+    m_directory.assign(CODE_LIMIT >> 8, 0);
+    m_pages.assign(256, 0);
+
+    // glyph indices are stored in 16 bits, which covers every sfnt font
+    if (!face || face->num_glyphs > 0xFFFF) return false;
+
+    // walk the charmap FreeType selected for the face (it prefers a full
+    // Unicode format 12 subtable over a BMP-only format 4 one)
+    FT_UInt index;
+    FT_ULong code = FT_Get_First_Char(face, &index);
+    while (index != 0)
+    {
+        if (code >= FT_ULong(CODE_LIMIT)) break;
+
+        unsigned short &page = m_directory[code >> 8];
+        if (page == 0) {
+            page = m_pages.size() / 256;
+            m_pages.resize(m_pages.size() + 256, 0);
+        }
+        m_pages[(size_t(page) << 8) | (code & 0xFF)] = index;
+
+        code = FT_Get_Next_Char(face, code, &index);
+    }
+
+    m_built = true;
+    return true;
+}
+
+// --------------------------------------------------------------------------
@@ -0,0 +1,52 @@
+// ==========================================================================
+// Flat Character-to-Glyph Lookup
+//
+// FT_Get_Char_Index walks the font's cmap subtable (a segment search for
+// format 4, a group search for format 12) on every call. A CharMap reads the
+// face's selected charmap once and stores it as a two-level page table over
+// the Unicode range: a directory of 0x1100 page numbers, one per block of 256
+// code points, and the pages themselves, with every empty block sharing page
+// zero. A lookup is then two array reads.
+// ==========================================================================
+#ifndef CHARMAP_H
+#define CHARMAP_H
+
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+class CharMap
+{
+    std::vector<unsigned short> m_directory;    // page number per 256 codes
+    std::vector<unsigned short> m_pages;        // glyph index per code
+    bool                        m_built;
+
+public:
+    // one past the largest Unicode code point
+    static const int CODE_LIMIT = 0x110000;
+
+    CharMap() : m_built(false)
+    {}
+
+    // fills the table from the face's current charmap, returning false if
+    // the face's glyph indices do not fit (the table then stays unbuilt)
+    bool Build(FT_Face face);
+
+    bool Built() const              { return m_built; }
+
+    // glyph index for a character code, 0 (missing glyph) if unmapped
+    unsigned int Lookup(int character) const
+    {
+        if (character < 0 || character >= CODE_LIMIT) return 0;
+        return m_pages[(unsigned(m_directory[character >> 8]) << 8) | (character & 0xFF)];
+    }
+
+    // number of non-empty pages, and memory used by the table in bytes
+    size_t PageCount() const        { return m_pages.size() / 256 - 1; }
+    size_t Bytes() const
+    { return (m_directory.size() + m_pages.size()) * sizeof(unsigned short); }
+};
+
+// --------------------------------------------------------------------------
+#endif // CHARMAP_H
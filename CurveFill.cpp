@@ -0,0 +1,445 @@
+// ==========================================================================
+// Resolution-Independent Curve Fill
+//
+// See CurveFill.h. The cubic coordinates follow Loop and Blinn's
+// classification; each of k, l and m is a product of linear factors of
+// the curve parameter, whose Bezier coefficients are found by blossoming,
+// so one routine serves every class.
+// ==========================================================================
+
+#include "CurveFill.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// determinants below this, relative to the largest, count as zero
+static const double EPSILON = 1e-6;
+
+// roots closer than this to an end of a cubic do not split it
+static const float SPLIT_MARGIN = 1e-4f;
+
+// splits of a cubic at inflection points, double points and halves
+static const int MAX_DEPTH = 6;
+
+// k^3 - l m halfway between curve and chord must stand out this far from
+// the size of its terms, or float rounding in the fragment shader decides
+// the curve's side; nearly straight cubics fail this
+static const float MIN_CONDITION = 1e-3f;
+
+// largest distance, in EM units, of the quadratics that replace a cubic
+// that fails it
+static const float QUADRATIC_TOLERANCE = 1e-5f;
+
+const float CurveFill::SOLID_COORDINATES[3] = { -1.f, 0.f, 0.f };
+const float CurveFill::QUADRATIC_COORDINATES[9] = { 0.f, 0.f, 0.f, 0.5f, 0.f, 0.5f, 1.f, 1.f, 1.f };
+
+// --------------------------------------------------------------------------
+
+void CurveMesh::Clear()
+{
+    solids.clear();
+    quadratics.clear();
+    cubics.clear();
+}
+
+size_t CurveMesh::Triangles() const
+{
+    return (solids.size() + quadratics.size()) / (3 * CurveFill::POSITION_FLOATS)
+         + cubics.size() / (3 * CurveFill::VERTEX_FLOATS);
+}
+
+size_t CurveMesh::Bytes() const
+{
+    return (solids.size() + quadratics.size() + cubics.size()) * sizeof(float);
+}
+
+// --------------------------------------------------------------------------
+
+// a linear factor of the curve parameter, by its values at t = 0 and 1
+struct Factor
+{
+    double  a, b;
+};
+
+// cubic Bezier coefficients of the product of three linear factors
+static void Blossom(const Factor &f, const Factor &g, const Factor &h, double c[4])
+{
+    c[0] = f.a * g.a * h.a;
+    c[1] = (f.b * g.a * h.a + f.a * g.b * h.a + f.a * g.a * h.b) / 3.0;
+    c[2] = (f.a * g.b * h.b + f.b * g.a * h.b + f.b * g.b * h.a) / 3.0;
+    c[3] = f.b * g.b * h.b;
+}
+
+// classifies a cubic, writes its coordinates and the parameters in (0, 1)
+// at which l or m vanish, which are its inflection or double points
+static CurveFill::CubicType Coordinates(const float *x, const float *y, float klm[12],
+                                        float roots[2], int &rootCount)
+{
+    rootCount = 0;
+
+    // a1 = b0 . (b3 x b2), a2 = b1 . (b0 x b3), a3 = b2 . (b1 x b0) for the
+    // control points in homogeneous form
+    double px[4], py[4];
+    for (int i = 0; i < 4; ++i) {
+        px[i] = x[i];
+        py[i] = y[i];
+    }
+    auto det = [&](int i, int j, int k) {
+        return px[i] * (py[j] - py[k]) - py[i] * (px[j] - px[k]) + (px[j] * py[k] - px[k] * py[j]);
+    };
+    double a1 = det(0, 3, 2), a2 = det(1, 0, 3), a3 = det(2, 1, 0);
+    double d1 = a1 - 2.0 * a2 + 3.0 * a3, d2 = -a2 + 3.0 * a3, d3 = 3.0 * a3;
+
+    double extent = 0.0;
+    for (int i = 1; i < 4; ++i)
+        extent = max(extent, max(fabs(px[i] - px[0]), fabs(py[i] - py[0])));
+    double largest = max(fabs(d1), max(fabs(d2), fabs(d3)));
+    if (largest <= EPSILON * extent * extent) return CurveFill::LINE;
+    d1 /= largest;
+    d2 /= largest;
+    d3 /= largest;
+
+    CurveFill::CubicType type;
+    Factor one = { 1.0, 1.0 }, l = one, m = one;
+    Factor kf[3], lf[3], mf[3];
+    if (fabs(d1) < EPSILON && fabs(d2) < EPSILON)
+    {
+        // k = t, l = t^2, m = t
+        Factor t = { 0.0, 1.0 };
+        kf[0] = t;  kf[1] = one; kf[2] = one;
+        lf[0] = t;  lf[1] = t;   lf[2] = one;
+        mf[0] = t;  mf[1] = one; mf[2] = one;
+        type = CurveFill::QUADRATIC;
+    }
+    else if (fabs(d1) < EPSILON)
+    {
+        // cusp at infinity: k = L, l = L^3, m = 1
+        double ls = d3, lt = 3.0 * d2;
+        l.a = ls;
+        l.b = ls - lt;
+        roots[rootCount++] = float(ls / lt);
+        kf[0] = l;  kf[1] = one; kf[2] = one;
+        lf[0] = l;  lf[1] = l;   lf[2] = l;
+        mf[0] = one; mf[1] = one; mf[2] = one;
+        type = CurveFill::CUSP;
+    }
+    else
+    {
+        double discriminant = 3.0 * d2 * d2 - 4.0 * d1 * d3;
+        double ls, lt, ms, mt;
+        if (discriminant >= -EPSILON) {
+            // serpentine, or a cusp where the two roots meet:
+            // k = L M, l = L^3, m = M^3
+            double r = sqrt(3.0 * max(discriminant, 0.0));
+            ls = 3.0 * d2 - r;
+            ms = 3.0 * d2 + r;
+            lt = mt = 6.0 * d1;
+            type = fabs(discriminant) < EPSILON ? CurveFill::CUSP : CurveFill::SERPENTINE;
+        }
+        else {
+            // loop: k = L M, l = L^2 M, m = L M^2
+            double r = sqrt(-discriminant);
+            ls = d2 - r;
+            ms = d2 + r;
+            lt = mt = 2.0 * d1;
+            type = CurveFill::LOOP;
+        }
+        l.a = ls;
+        l.b = ls - lt;
+        m.a = ms;
+        m.b = ms - mt;
+        roots[rootCount++] = float(ls / lt);
+        roots[rootCount++] = float(ms / mt);
+
+        kf[0] = l;  kf[1] = m;  kf[2] = one;
+        if (type == CurveFill::LOOP) {
+            lf[0] = l;  lf[1] = l;  lf[2] = m;
+            mf[0] = l;  mf[1] = m;  mf[2] = m;
+        }
+        else {
+            lf[0] = l;  lf[1] = l;  lf[2] = l;
+            mf[0] = m;  mf[1] = m;  mf[2] = m;
+        }
+    }
+
+    double k[4], lc[4], mc[4];
+    Blossom(kf[0], kf[1], kf[2], k);
+    Blossom(lf[0], lf[1], lf[2], lc);
+    Blossom(mf[0], mf[1], mf[2], mc);
+    for (int i = 0; i < 4; ++i) {
+        klm[3*i]     = float(k[i]);
+        klm[3*i + 1] = float(lc[i]);
+        klm[3*i + 2] = float(mc[i]);
+    }
+
+    // keep only the roots strictly inside the curve
+    int inside = 0;
+    for (int i = 0; i < rootCount; ++i)
+        if (roots[i] > SPLIT_MARGIN && roots[i] < 1.f - SPLIT_MARGIN) roots[inside++] = roots[i];
+    rootCount = inside;
+    return type;
+}
+
+CurveFill::CubicType CurveFill::Classify(const float *x, const float *y, float klm[12])
+{
+    float roots[2];
+    int rootCount;
+    return Coordinates(x, y, klm, roots, rootCount);
+}
+
+// --------------------------------------------------------------------------
+
+namespace {
+
+// de Casteljau split of a cubic at t into its two halves
+void SplitCubic(const float *x, const float *y, float t, float *lx, float *ly, float *rx, float *ry)
+{
+    float x01 = x[0] + (x[1] - x[0]) * t, y01 = y[0] + (y[1] - y[0]) * t;
+    float x12 = x[1] + (x[2] - x[1]) * t, y12 = y[1] + (y[2] - y[1]) * t;
+    float x23 = x[2] + (x[3] - x[2]) * t, y23 = y[2] + (y[3] - y[2]) * t;
+    float xa = x01 + (x12 - x01) * t, ya = y01 + (y12 - y01) * t;
+    float xb = x12 + (x23 - x12) * t, yb = y12 + (y23 - y12) * t;
+    float xm = xa + (xb - xa) * t, ym = ya + (yb - ya) * t;
+    lx[0] = x[0]; lx[1] = x01; lx[2] = xa; lx[3] = xm;
+    ly[0] = y[0]; ly[1] = y01; ly[2] = ya; ly[3] = ym;
+    rx[0] = xm;   rx[1] = xb;  rx[2] = x23; rx[3] = x[3];
+    ry[0] = ym;   ry[1] = yb;  ry[2] = y23; ry[3] = y[3];
+}
+
+float Cross(float ax, float ay, float bx, float by)
+{
+    return ax * by - ay * bx;
+}
+
+// writes the fill triangles of one glyph's contours
+class Builder
+{
+    CurveMesh       &m_mesh;
+    unsigned long   *m_counts;
+    float           m_originX;
+    float           m_originY;
+    bool            m_started;
+
+    void Vertex(float x, float y, float k, float l, float m)
+    {
+        float v[CurveFill::VERTEX_FLOATS] = { x, y, k, l, m };
+        m_mesh.cubics.insert(m_mesh.cubics.end(), v, v + CurveFill::VERTEX_FLOATS);
+    }
+
+    // a triangle of the interior polygon, never discarded
+    void Solid(float x0, float y0, float x1, float y1, float x2, float y2)
+    {
+        if (Cross(x1 - x0, y1 - y0, x2 - x0, y2 - y0) == 0.f) return;
+        float v[6] = { x0, y0, x1, y1, x2, y2 };
+        m_mesh.solids.insert(m_mesh.solids.end(), v, v + 6);
+    }
+
+    // a quadratic curve triangle, its corners in the order of
+    // QUADRATIC_COORDINATES
+    void Quadratic(const float *x, const float *y)
+    {
+        if (Cross(x[1] - x[0], y[1] - y[0], x[2] - x[0], y[2] - y[0]) == 0.f) return;
+        float v[6] = { x[0], y[0], x[1], y[1], x[2], y[2] };
+        m_mesh.quadratics.insert(m_mesh.quadratics.end(), v, v + 6);
+    }
+
+    void Cubic(const float *x, const float *y, int depth);
+    void CubicAsQuadratics(const float *x, const float *y);
+
+public:
+    Builder(CurveMesh &mesh, unsigned long *counts)
+        : m_mesh(mesh), m_counts(counts), m_originX(0.f), m_originY(0.f), m_started(false)
+    {}
+
+    void BeginContour()                 { m_started = false; }
+
+    void Segment(int degree, const float *x, const float *y)
+    {
+        if (degree < 1 || degree > 3) return;
+        if (!m_started) {
+            m_originX = x[0];
+            m_originY = y[0];
+            m_started = true;
+        }
+        Solid(m_originX, m_originY, x[0], y[0], x[degree], y[degree]);
+        if (degree == 2)
+            Quadratic(x, y);
+        else if (degree == 3)
+            Cubic(x, y, 0);
+    }
+};
+
+void Builder::Cubic(const float *x, const float *y, int depth)
+{
+    float klm[12], roots[2];
+    int rootCount;
+    CurveFill::CubicType type = Coordinates(x, y, klm, roots, rootCount);
+
+    // pieces must not inflect, loop or cross their chord, so that the
+    // region between curve and chord lies on one side of it
+    float chordX = x[3] - x[0], chordY = y[3] - y[0];
+    float side1 = Cross(x[1] - x[0], y[1] - y[0], chordX, chordY);
+    float side2 = Cross(x[2] - x[0], y[2] - y[0], chordX, chordY);
+    if (depth < MAX_DEPTH && type != CurveFill::LINE
+        && (rootCount > 0 || (side1 < 0.f && side2 > 0.f) || (side1 > 0.f && side2 < 0.f)))
+    {
+        float lx[4], ly[4], rx[4], ry[4];
+        SplitCubic(x, y, rootCount > 0 ? roots[0] : 0.5f, lx, ly, rx, ry);
+
+        // the chord becomes two chords through the split point
+        Solid(x[0], y[0], lx[3], ly[3], x[3], y[3]);
+        Cubic(lx, ly, depth + 1);
+        Cubic(rx, ry, depth + 1);
+        return;
+    }
+    if (m_counts) ++m_counts[type];
+    float orientation = side1 + side2;
+    if (type == CurveFill::LINE || orientation == 0.f) return;
+
+    // k^3 - l m must be negative on the chord side: test halfway between
+    // the curve's midpoint and the chord's, both affine combinations of
+    // the control points, so their coordinates combine the same way
+    float probe[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        float curve = 0.125f * (klm[c] + 3.f * klm[3 + c] + 3.f * klm[6 + c] + klm[9 + c]);
+        float chord = 0.5f * (klm[c] + klm[9 + c]);
+        probe[c] = 0.5f * (curve + chord);
+    }
+    float value = CurveFill::Implicit(probe[0], probe[1], probe[2]);
+    float terms = max(fabs(probe[0] * probe[0] * probe[0]), fabs(probe[1] * probe[2]));
+    if (!(fabs(value) > MIN_CONDITION * terms)) {
+        CubicAsQuadratics(x, y);
+        return;
+    }
+    if (value > 0.f)
+        for (int i = 0; i < 4; ++i) {
+            klm[3*i] = -klm[3*i];
+            klm[3*i + 1] = -klm[3*i + 1];
+        }
+
+    // convex hull of the control points (monotone chain), fanned with the
+    // orientation of the region between curve and chord
+    int order[4] = { 0, 1, 2, 3 };
+    sort(order, order + 4, [&](int a, int b) { return x[a] < x[b] || (x[a] == x[b] && y[a] < y[b]); });
+    int hull[8], count = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        int start = count;
+        for (int j = 0; j < 4; ++j)
+        {
+            int i = pass == 0 ? order[j] : order[3 - j];
+            while (count >= start + 2
+                   && Cross(x[hull[count - 1]] - x[hull[count - 2]], y[hull[count - 1]] - y[hull[count - 2]],
+                            x[i] - x[hull[count - 2]], y[i] - y[hull[count - 2]]) <= 0.f)
+                --count;
+            hull[count++] = i;
+        }
+        --count;
+    }
+    for (int h = 1; h + 1 < count; ++h)
+    {
+        int corners[3] = { hull[0], hull[h], hull[h + 1] };
+        if (orientation < 0.f) swap(corners[1], corners[2]);
+        for (int c = 0; c < 3; ++c) {
+            int i = corners[c];
+            Vertex(x[i], y[i], klm[3*i], klm[3*i + 1], klm[3*i + 2]);
+        }
+    }
+}
+
+}
+
+// n equal pieces of the cubic, each replaced by the quadratic through its
+// end points with the control point (3 (p1 + p2) - (p0 + p3)) / 4, which
+// stays within sqrt(3) / 36 |p3 - 3 p2 + 3 p1 - p0| / n^3 of it
+void Builder::CubicAsQuadratics(const float *x, const float *y)
+{
+    float dx = x[3] - 3.f * x[2] + 3.f * x[1] - x[0], dy = y[3] - 3.f * y[2] + 3.f * y[1] - y[0];
+    float error = sqrtf(3.f) / 36.f * hypotf(dx, dy);
+    int pieces = max(1, min(64, int(ceil(cbrt(error / QUADRATIC_TOLERANCE)))));
+
+    float rest[2][4] = { { x[0], x[1], x[2], x[3] }, { y[0], y[1], y[2], y[3] } };
+    for (int i = 0; i < pieces; ++i)
+    {
+        float px[4], py[4], rx[4], ry[4];
+        if (i + 1 < pieces)
+            SplitCubic(rest[0], rest[1], 1.f / (pieces - i), px, py, rx, ry);
+        else {
+            copy(rest[0], rest[0] + 4, px);
+            copy(rest[1], rest[1] + 4, py);
+        }
+
+        // the chord from p0 gains a corner at every piece's end
+        Solid(x[0], y[0], px[0], py[0], px[3], py[3]);
+        float qx[3] = { px[0], 0.25f * (3.f * (px[1] + px[2]) - px[0] - px[3]), px[3] };
+        float qy[3] = { py[0], 0.25f * (3.f * (py[1] + py[2]) - py[0] - py[3]), py[3] };
+        Quadratic(qx, qy);
+
+        copy(rx, rx + 4, rest[0]);
+        copy(ry, ry + 4, rest[1]);
+    }
+}
+
+// --------------------------------------------------------------------------
+
+void CurveFill::Build(const MyGlyphView &glyph, CurveMesh &mesh, unsigned long *counts)
+{
+    mesh.Clear();
+    if (!glyph.Valid()) return;
+
+    Builder builder(mesh, counts);
+    const unsigned int *contours = glyph.ContourSegments();
+    const unsigned int *first = glyph.SegmentPoints();
+    const unsigned char *degrees = glyph.SegmentDegrees();
+    const float *points = glyph.Points();
+    for (unsigned int c = 0; c < glyph.ContourCount(); ++c)
+    {
+        builder.BeginContour();
+        for (unsigned int seg = contours[c]; seg < contours[c + 1]; ++seg)
+        {
+            int degree = degrees[seg];
+            if (degree < 1 || degree > 3) continue;
+            const float *p = points + 2 * first[seg];
+            float x[4], y[4];
+            for (int v = 0; v <= degree; ++v) {
+                x[v] = p[2*v];
+                y[v] = p[2*v + 1];
+            }
+            builder.Segment(degree, x, y);
+        }
+    }
+}
+
+void CurveFill::Build(const MyGlyph &glyph, CurveMesh &mesh, unsigned long *counts)
+{
+    mesh.Clear();
+    Builder builder(mesh, counts);
+    for (size_t c = 0; c < glyph.contours.size(); ++c)
+    {
+        builder.BeginContour();
+        for (size_t s = 0; s < glyph.contours[c].size(); ++s) {
+            const MySegment &segment = glyph.contours[c][s];
+            builder.Segment(segment.degree, segment.x, segment.y);
+        }
+    }
+}
+
+void CurveFill::Expand(const CurveMesh &mesh, vector<float> &vertices)
+{
+    vertices.clear();
+    vertices.reserve(mesh.Triangles() * 3 * VERTEX_FLOATS);
+    for (size_t i = 0; i + 1 < mesh.solids.size(); i += 2) {
+        vertices.insert(vertices.end(), &mesh.solids[i], &mesh.solids[i] + 2);
+        vertices.insert(vertices.end(), SOLID_COORDINATES, SOLID_COORDINATES + 3);
+    }
+    for (size_t i = 0; i + 1 < mesh.quadratics.size(); i += 2) {
+        const float *corner = QUADRATIC_COORDINATES + 3 * (i / 2 % 3);
+        vertices.insert(vertices.end(), &mesh.quadratics[i], &mesh.quadratics[i] + 2);
+        vertices.insert(vertices.end(), corner, corner + 3);
+    }
+    vertices.insert(vertices.end(), mesh.cubics.begin(), mesh.cubics.end());
+}
+
+// --------------------------------------------------------------------------
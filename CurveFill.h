@@ -0,0 +1,87 @@
+// ==========================================================================
+// Resolution-Independent Curve Fill
+//
+// Builds a small triangle mesh that fills a glyph exactly at any scale, in
+// the manner of Loop and Blinn: every contour contributes a fan of
+// triangles over its on-curve points (its interior polygon with straight
+// chords), and every curve segment one triangle, or a fan over the convex
+// hull of a cubic, carrying implicit coordinates (k, l, m) chosen so that
+// k^3 - l m is zero on the curve and negative between the curve and its
+// chord. The fragment shader discards where it is positive, which leaves
+// each curve triangle covering exactly the region between curve and chord.
+//
+// The triangles of a contour overlap and cancel rather than tile, so they
+// are resolved by counting: a triangle adds +1 or -1 to the winding of the
+// pixels it covers according to its orientation (the stencil buffer's
+// front and back face operations), and pixels with a nonzero count are
+// then painted. Holes, overlapping contours and thin stems need no special
+// handling, since the counts add up to the outline's winding number.
+//
+// Quadratics use the canonical coordinates (0, 0, 0), (1/2, 0, 1/2),
+// (1, 1, 1). Cubics are classified (serpentine, cusp, loop, quadratic or
+// line) from the determinants of their control points, split at inflection
+// and double points so that no piece crosses its own chord, and given the
+// coordinates of their class; degenerate cubics that are straight lines add
+// no curve triangle at all. Nearly straight cubics, whose coordinates are
+// too close to constant for float precision, are replaced by quadratics
+// within 1e-5 EM instead.
+//
+// Interior triangles all carry (-1, 0, 0), and quadratic curve triangles
+// the same canonical coordinates in corner order, so both are stored as
+// positions alone and given their coordinates when drawn; only cubic curve
+// triangles store (x, y, k, l, m) per vertex. Positions are in EM units.
+// ==========================================================================
+#ifndef CURVEFILL_H
+#define CURVEFILL_H
+
+#include <vector>
+
+#include "GlyphExtractor.h"
+
+// the fill triangles of a glyph by kind, each a plain triangle list
+struct CurveMesh
+{
+    std::vector<float>  solids;         // interior triangles, (x, y)
+    std::vector<float>  quadratics;     // quadratic curve triangles, (x, y)
+    std::vector<float>  cubics;         // cubic curve triangles, (x, y, k, l, m)
+
+    void Clear();
+    size_t Triangles() const;
+    size_t Bytes() const;
+};
+
+class CurveFill
+{
+public:
+    enum CubicType { SERPENTINE, CUSP, LOOP, QUADRATIC, LINE };
+
+    // floats per vertex of the cubic triangles (position and implicit
+    // coordinates) and of the others (position)
+    static const int VERTEX_FLOATS = 5;
+    static const int POSITION_FLOATS = 2;
+
+    // (k, l, m) of every interior vertex, and of the three corners of
+    // every quadratic curve triangle in order
+    static const float SOLID_COORDINATES[3];
+    static const float QUADRATIC_COORDINATES[9];
+
+    // classifies a cubic and writes the (k, l, m) of each of its four
+    // control points into klm, or leaves it untouched for a LINE
+    static CubicType Classify(const float *x, const float *y, float klm[12]);
+
+    // the value the fragment shader tests, k^3 - l m
+    static float Implicit(float k, float l, float m)    { return k * k * k - l * m; }
+
+    // builds the fill triangles of a glyph, replacing the contents of
+    // [mesh]; the number of each cubic class met is added to [counts]
+    // (indexed by CubicType) if it is given
+    static void Build(const MyGlyphView &glyph, CurveMesh &mesh, unsigned long *counts = 0);
+    static void Build(const MyGlyph &glyph, CurveMesh &mesh, unsigned long *counts = 0);
+
+    // writes every triangle of a mesh as it is drawn, with the coordinates
+    // of each vertex filled in: a list of (x, y, k, l, m) vertices
+    static void Expand(const CurveMesh &mesh, std::vector<float> &vertices);
+};
+
+// --------------------------------------------------------------------------
+#endif // CURVEFILL_H
@@ -0,0 +1,218 @@
+// ==========================================================================
+// Adaptive Outline Flattening
+//
+// See Flattener.h. For a Bezier curve of degree d with second differences
+// of its control points bounded by M, Wang's formula says that n equal
+// parameter steps keep every chord within d (d - 1) M / (8 n^2) of the
+// curve, so a quadratic needs n = ceil(sqrt(M / (4 tolerance))) steps and a
+// cubic n = ceil(sqrt(3 M / (4 tolerance))).
+//
+// A cubic is accepted as flat when
+//     max(ux^2, vx^2) + max(uy^2, vy^2) <= 16 tolerance^2
+// with u = 3 p1 - 2 p0 - p3 and v = 3 p2 - p0 - 2 p3, which bounds the
+// distance between the curve and its chord (Hain, "Rapid Termination
+// Evaluation for Recursive Subdivision of Bezier Curves"); otherwise it is
+// halved with de Casteljau's construction.
+// ==========================================================================
+
+#include "Flattener.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+// writes points and contour boundaries into a target, counting what did not fit
+
+namespace
+{
+    struct Emitter
+    {
+        FlattenTarget &target;
+        size_t contourStart;
+
+        Emitter(FlattenTarget &target) : target(target), contourStart(target.pointCount)
+        {}
+
+        void Point(float x, float y)
+        {
+            size_t i = target.pointCount++;
+            if (i < target.pointCapacity) {
+                target.points[2*i]     = x;
+                target.points[2*i + 1] = y;
+            }
+        }
+
+        void BeginContour(float x, float y)
+        {
+            contourStart = target.pointCount;
+            Point(x, y);
+        }
+
+        // a contour that gained no segment past its first point is dropped
+        void EndContour()
+        {
+            if (target.pointCount - contourStart < 2) {
+                target.pointCount = contourStart;
+                return;
+            }
+            size_t c = target.contourCount++;
+            if (c + 1 < target.startCapacity) {
+                target.starts[c]     = (unsigned int)contourStart;
+                target.starts[c + 1] = (unsigned int)target.pointCount;
+            }
+        }
+
+        void Cubic(const float *x, const float *y, float tolerance2, int depth)
+        {
+            float ux = 3.f * x[1] - 2.f * x[0] - x[3], uy = 3.f * y[1] - 2.f * y[0] - y[3];
+            float vx = 3.f * x[2] - x[0] - 2.f * x[3], vy = 3.f * y[2] - y[0] - 2.f * y[3];
+            if (depth >= Flattener::MAX_DEPTH ||
+                max(ux * ux, vx * vx) + max(uy * uy, vy * vy) <= 16.f * tolerance2) {
+                Point(x[3], y[3]);
+                return;
+            }
+
+            float x01 = 0.5f * (x[0] + x[1]), y01 = 0.5f * (y[0] + y[1]);
+            float x12 = 0.5f * (x[1] + x[2]), y12 = 0.5f * (y[1] + y[2]);
+            float x23 = 0.5f * (x[2] + x[3]), y23 = 0.5f * (y[2] + y[3]);
+            float xa = 0.5f * (x01 + x12), ya = 0.5f * (y01 + y12);
+            float xb = 0.5f * (x12 + x23), yb = 0.5f * (y12 + y23);
+            float xm = 0.5f * (xa + xb), ym = 0.5f * (ya + yb);
+
+            float lx[4] = { x[0], x01, xa, xm }, ly[4] = { y[0], y01, ya, ym };
+            float rx[4] = { xm, xb, x23, x[3] }, ry[4] = { ym, yb, y23, y[3] };
+            Cubic(lx, ly, tolerance2, depth + 1);
+            Cubic(rx, ry, tolerance2, depth + 1);
+        }
+
+        // appends a segment after its start point, which is already out
+        void Segment(int degree, const float *x, const float *y, float tolerance)
+        {
+            if (degree == 1)
+                Point(x[1], y[1]);
+            else if (degree == 2) {
+                int steps = Flattener::QuadraticSteps(x, y, tolerance);
+                for (int k = 1; k < steps; ++k) {
+                    float u = float(k) / steps, b = 1.f - u;
+                    float w0 = b * b, w1 = 2.f * b * u, w2 = u * u;
+                    Point(w0 * x[0] + w1 * x[1] + w2 * x[2], w0 * y[0] + w1 * y[1] + w2 * y[2]);
+                }
+                Point(x[2], y[2]);
+            }
+            else if (degree == 3)
+                Cubic(x, y, tolerance * tolerance, 0);
+        }
+    };
+}
+
+// --------------------------------------------------------------------------
+
+int Flattener::QuadraticSteps(const float *x, const float *y, float tolerance)
+{
+    float m = hypotf(x[0] - 2.f * x[1] + x[2], y[0] - 2.f * y[1] + y[2]);
+    float steps = ceil(sqrt(m / (4.f * max(tolerance, 1e-12f))));
+    return int(min(max(steps, 1.f), float(1 << MAX_DEPTH)));
+}
+
+int Flattener::CubicSteps(const float *x, const float *y, float tolerance)
+{
+    float m = max(hypotf(x[0] - 2.f * x[1] + x[2], y[0] - 2.f * y[1] + y[2]),
+                  hypotf(x[1] - 2.f * x[2] + x[3], y[1] - 2.f * y[2] + y[3]));
+    float steps = ceil(sqrt(0.75f * m / max(tolerance, 1e-12f)));
+    return int(min(max(steps, 1.f), float(1 << MAX_DEPTH)));
+}
+
+void Flattener::Flatten(const MyContour &contour, float tolerance, FlattenTarget &target)
+{
+    Emitter emit(target);
+    bool started = false;
+    for (size_t s = 0; s < contour.size(); ++s)
+    {
+        const MySegment &segment = contour[s];
+        if (segment.degree < 1 || segment.degree > 3) continue;
+        if (!started) {
+            emit.BeginContour(segment.x[0], segment.y[0]);
+            started = true;
+        }
+        emit.Segment(segment.degree, segment.x, segment.y, tolerance);
+    }
+    if (started) emit.EndContour();
+}
+
+void Flattener::Flatten(const MyGlyph &glyph, float tolerance, FlattenTarget &target)
+{
+    for (size_t c = 0; c < glyph.contours.size(); ++c)
+        Flatten(glyph.contours[c], tolerance, target);
+}
+
+void Flattener::Flatten(const MyGlyphView &glyph, float tolerance, FlattenTarget &target,
+                        float scale, float xTrans, float yTrans)
+{
+    if (!glyph.Valid()) return;
+
+    const unsigned int *contours = glyph.ContourSegments();
+    const unsigned int *first = glyph.SegmentPoints();
+    const unsigned char *degrees = glyph.SegmentDegrees();
+    const float *points = glyph.Points();
+
+    Emitter emit(target);
+    for (unsigned int c = 0; c < glyph.ContourCount(); ++c)
+    {
+        bool started = false;
+        for (unsigned int seg = contours[c]; seg < contours[c + 1]; ++seg)
+        {
+            int degree = degrees[seg];
+            if (degree < 1 || degree > 3) continue;
+
+            float x[4], y[4];
+            const float *p = points + 2 * first[seg];
+            for (int v = 0; v <= degree; ++v) {
+                x[v] = (p[2*v]     + xTrans) * scale;
+                y[v] = (p[2*v + 1] + yTrans) * scale;
+            }
+            if (!started) {
+                emit.BeginContour(x[0], y[0]);
+                started = true;
+            }
+            emit.Segment(degree, x, y, tolerance);
+        }
+        if (started) emit.EndContour();
+    }
+}
+
+// --------------------------------------------------------------------------
+// the Polylines forms try the vectors' current size first and grow them
+// to the reported requirement only when that was not enough
+
+template <class Flatten>
+static void FlattenInto(Polylines &output, Flatten flatten)
+{
+    output.points.resize(max(output.points.capacity(), size_t(2)) & ~size_t(1));
+    output.starts.resize(max(output.starts.capacity(), size_t(1)));
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        FlattenTarget target(&output.points[0], output.points.size() / 2,
+                             &output.starts[0], output.starts.size());
+        flatten(target);
+        output.points.resize(2 * target.pointCount);
+        output.starts.resize(target.contourCount + 1);
+        if (target.Complete()) break;
+    }
+    output.starts[0] = 0;
+}
+
+void Flattener::Flatten(const MyGlyph &glyph, float tolerance, Polylines &output)
+{
+    FlattenInto(output, [&](FlattenTarget &target) { Flatten(glyph, tolerance, target); });
+}
+
+void Flattener::Flatten(const MyGlyphView &glyph, float tolerance, Polylines &output,
+                        float scale, float xTrans, float yTrans)
+{
+    FlattenInto(output, [&](FlattenTarget &target) {
+        Flatten(glyph, tolerance, target, scale, xTrans, yTrans);
+    });
+}
+
+// --------------------------------------------------------------------------
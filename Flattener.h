@@ -0,0 +1,76 @@
+// ==========================================================================
+// Adaptive Outline Flattening
+//
+// Converts contours and glyphs into polylines that stay within a given
+// distance of the true outline, for code that needs straight edges on the
+// CPU (fill triangulation, rasterization, export). Quadratic segments are
+// split into the number of equal steps Wang's formula guarantees for the
+// tolerance; cubic segments are subdivided recursively at u = 1/2 until the
+// control polygon is flat enough that the chord is within tolerance.
+// Straight segments are emitted as they are.
+//
+// Each contour becomes one closed polyline whose last point repeats its
+// first. The flattener never allocates: it writes into the caller's arrays
+// and reports how much room it needed, so a caller can size its buffers
+// once and retry only when they were too small. The tolerance is in the
+// units of the outline, e.g. pixels divided by pixels per EM for glyphs.
+// ==========================================================================
+#ifndef FLATTENER_H
+#define FLATTENER_H
+
+#include <cstddef>
+
+#include "GlyphExtractor.h"
+#include "Tessellator.h"
+
+// caller-owned output storage; contour c is points [starts[c], starts[c+1])
+struct FlattenTarget
+{
+    float           *points;        // interleaved (x, y)
+    size_t          pointCapacity;  // in points, not floats
+    unsigned int    *starts;
+    size_t          startCapacity;  // contour count + 1 entries are needed
+
+    // set by the flattener: the points and contours the input requires,
+    // which may exceed the capacities, in which case the output is partial
+    size_t          pointCount;
+    size_t          contourCount;
+
+    FlattenTarget(float *points = 0, size_t pointCapacity = 0,
+                  unsigned int *starts = 0, size_t startCapacity = 0)
+        : points(points), pointCapacity(pointCapacity), starts(starts),
+          startCapacity(startCapacity), pointCount(0), contourCount(0)
+    {}
+
+    // true if everything fit
+    bool Complete() const
+    { return pointCount <= pointCapacity && contourCount < startCapacity; }
+};
+
+class Flattener
+{
+public:
+    // equal steps that keep a quadratic or cubic within [tolerance] of its
+    // chords, for callers that sample segments uniformly, and the deepest
+    // subdivision of a cubic
+    static int QuadraticSteps(const float *x, const float *y, float tolerance);
+    static int CubicSteps(const float *x, const float *y, float tolerance);
+    static const int MAX_DEPTH = 16;
+
+    // appends one contour, or every contour of a glyph, to the target; a
+    // glyph view in a run is flattened at the given placement so that its
+    // points come out in the same space as GlyphGeometry's
+    static void Flatten(const MyContour &contour, float tolerance, FlattenTarget &target);
+    static void Flatten(const MyGlyph &glyph, float tolerance, FlattenTarget &target);
+    static void Flatten(const MyGlyphView &glyph, float tolerance, FlattenTarget &target,
+                        float scale = 1.f, float xTrans = 0.f, float yTrans = 0.f);
+
+    // flattens a glyph into a Polylines set, replacing its contents; the
+    // vectors only grow when a glyph needs more room than any before it
+    static void Flatten(const MyGlyph &glyph, float tolerance, Polylines &output);
+    static void Flatten(const MyGlyphView &glyph, float tolerance, Polylines &output,
+                        float scale = 1.f, float xTrans = 0.f, float yTrans = 0.f);
+};
+
+// --------------------------------------------------------------------------
+#endif // FLATTENER_H
@@ -0,0 +1,216 @@
+// ==========================================================================
+// Font Registry for the GlyphExtractor
+//
+// A FontRegistry owns a FreeType library instance and every face opened
+// through it. Each font file is registered once and identified by a small
+// integer handle; the registry keeps at most a fixed number of faces live at
+// a time, closing the least recently used one when the bound is reached and
+// transparently reopening it when its handle is used again.
+//
+// By default faces are created with FT_New_Memory_Face over a shared
+// read-only mapping of the font file (see MappedFile), which stays alive as
+// long as the font is registered, so reopening an evicted face costs no I/O.
+// ==========================================================================
+
+#include "FontRegistry.h"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+FontRegistry::FontRegistry(size_t maxFaces)
+    : m_library(0), m_maxFaces(maxFaces ? maxFaces : 1), m_liveFaces(0),
+      m_useMapping(true), m_clock(0), m_facesOpened(0), m_facesEvicted(0)
+{
+    // initialize freetype library
+    FT_Error error = FT_Init_FreeType(&m_library);
+    if (error) {
+        cout << "ERROR: FreeType failed to initialize!" << endl;
+        m_library = 0;
+    }
+}
+
+FontRegistry::~FontRegistry()
+{
+    for (size_t i = 0; i < m_fonts.size(); ++i)
+        if (m_fonts[i].face) FT_Done_Face(m_fonts[i].face);
+    if (m_library) FT_Done_FreeType(m_library);
+}
+
+// --------------------------------------------------------------------------
+
+bool FontRegistry::OpenFace(FontEntry &entry)
+{
+    if (!m_library) return false;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    PageFaults before = PageFaults::Now();
+
+    // map the file the first time a memory face is wanted; the mapping is
+    // kept for the life of the entry, so later reopens reuse it
+    if (m_useMapping && !entry.file) {
+        entry.file = MappedFile::Open(entry.filename);
+        if (entry.file) entry.stats.mappedBytes = entry.file->Size();
+    }
+
+    FT_Error error;
+    if (m_useMapping && entry.file)
+        error = FT_New_Memory_Face(m_library, entry.file->Data(), entry.file->Size(), 0, &entry.face);
+    else
+        error = FT_New_Face(m_library, entry.filename.c_str(), 0, &entry.face);
+
+    PageFaults after = PageFaults::Now();
+    entry.stats.minorFaults += after.minor - before.minor;
+    entry.stats.majorFaults += after.major - before.major;
+    entry.stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (error == FT_Err_Unknown_File_Format) {
+        cout << "Freetype ERROR: unsupported file format in " << entry.filename << endl;
+        entry.face = 0;
+        return false;
+    }
+    else if (error) {
+        cout << "FreeType ERROR: unknown error occurred." << endl;
+        entry.face = 0;
+        return false;
+    }
+
+    ++m_liveFaces;
+    ++m_facesOpened;
+    ++entry.stats.loads;
+
+    if (entry.stats.loads == 1) {
+        entry.charMap.Build(entry.face);
+        entry.kerning.Build(entry.face);
+    }
+    return true;
+}
+
+void FontRegistry::MakeRoom(FontHandle keep)
+{
+    while (m_liveFaces >= m_maxFaces)
+    {
+        // find the least recently used live face other than the one kept
+        FontHandle victim = INVALID_FONT;
+        for (size_t i = 0; i < m_fonts.size(); ++i)
+        {
+            if (!m_fonts[i].face || FontHandle(i) == keep) continue;
+            if (victim == INVALID_FONT || m_fonts[i].lastUse < m_fonts[victim].lastUse)
+                victim = i;
+        }
+        if (victim == INVALID_FONT) return;
+
+        FT_Done_Face(m_fonts[victim].face);
+        m_fonts[victim].face = 0;
+        --m_liveFaces;
+        ++m_facesEvicted;
+    }
+}
+
+// --------------------------------------------------------------------------
+
+FontHandle FontRegistry::Open(const string &filename)
+{
+    map<string, FontHandle>::const_iterator it = m_handles.find(filename);
+    if (it != m_handles.end())
+        return Face(it->second) ? it->second : INVALID_FONT;
+
+    FontEntry entry;
+    entry.filename = filename;
+    entry.face = 0;
+    entry.lastUse = ++m_clock;
+
+    MakeRoom(INVALID_FONT);
+    if (!OpenFace(entry)) return INVALID_FONT;
+
+    FontHandle handle = m_fonts.size();
+    m_fonts.push_back(entry);
+    m_handles[filename] = handle;
+    return handle;
+}
+
+FontHandle FontRegistry::Find(const string &filename) const
+{
+    map<string, FontHandle>::const_iterator it = m_handles.find(filename);
+    return it != m_handles.end() ? it->second : INVALID_FONT;
+}
+
+FT_Face FontRegistry::Face(FontHandle handle)
+{
+    if (handle < 0 || size_t(handle) >= m_fonts.size()) return 0;
+
+    FontEntry &entry = m_fonts[handle];
+    entry.lastUse = ++m_clock;
+    if (!entry.face)
+    {
+        MakeRoom(handle);
+        OpenFace(entry);
+    }
+    return entry.face;
+}
+
+void FontRegistry::CloseFace(FontHandle handle)
+{
+    if (handle < 0 || size_t(handle) >= m_fonts.size() || !m_fonts[handle].face) return;
+
+    FT_Done_Face(m_fonts[handle].face);
+    m_fonts[handle].face = 0;
+    --m_liveFaces;
+}
+
+FT_Error FontRegistry::NewFace(FontHandle handle, FT_Face *face) const
+{
+    if (!m_library || handle < 0 || size_t(handle) >= m_fonts.size())
+        return FT_Err_Invalid_Argument;
+
+    const FontEntry &entry = m_fonts[handle];
+    if (entry.file)
+        return FT_New_Memory_Face(m_library, entry.file->Data(), entry.file->Size(), 0, face);
+    return FT_New_Face(m_library, entry.filename.c_str(), 0, face);
+}
+
+const CharMap &FontRegistry::CharacterMap(FontHandle handle) const
+{
+    static const CharMap none;
+    if (handle < 0 || size_t(handle) >= m_fonts.size()) return none;
+    return m_fonts[handle].charMap;
+}
+
+const KerningTable &FontRegistry::Kerning(FontHandle handle) const
+{
+    static const KerningTable none;
+    if (handle < 0 || size_t(handle) >= m_fonts.size()) return none;
+    return m_fonts[handle].kerning;
+}
+
+const string &FontRegistry::Filename(FontHandle handle) const
+{
+    static const string none;
+    if (handle < 0 || size_t(handle) >= m_fonts.size()) return none;
+    return m_fonts[handle].filename;
+}
+
+const FontLoadStats &FontRegistry::LoadStats(FontHandle handle) const
+{
+    static const FontLoadStats none;
+    if (handle < 0 || size_t(handle) >= m_fonts.size()) return none;
+    return m_fonts[handle].stats;
+}
+
+void FontRegistry::SetMaxFaces(size_t maxFaces)
+{
+    m_maxFaces = maxFaces ? maxFaces : 1;
+
+    // MakeRoom leaves space for one more face, so trim against a bound one
+    // higher to end up with exactly m_maxFaces live
+    if (m_liveFaces > m_maxFaces)
+    {
+        ++m_maxFaces;
+        MakeRoom(INVALID_FONT);
+        --m_maxFaces;
+    }
+}
+
+// --------------------------------------------------------------------------
@@ -0,0 +1,142 @@
+// ==========================================================================
+// Font Registry for the GlyphExtractor
+//
+// A FontRegistry owns a FreeType library instance and every face opened
+// through it. Each font file is registered once and identified by a small
+// integer handle; the registry keeps at most a fixed number of faces live at
+// a time, closing the least recently used one when the bound is reached and
+// transparently reopening it when its handle is used again.
+//
+// By default faces are created with FT_New_Memory_Face over a shared
+// read-only mapping of the font file (see MappedFile), which stays alive as
+// long as the font is registered, so reopening an evicted face costs no I/O.
+// ==========================================================================
+#ifndef FONTREGISTRY_H
+#define FONTREGISTRY_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "CharMap.h"
+#include "KerningTable.h"
+#include "MappedFile.h"
+
+// identifies a font registered with a FontRegistry (-1 is never valid)
+typedef int FontHandle;
+const FontHandle INVALID_FONT = -1;
+
+// statistics gathered each time a font's face is created
+struct FontLoadStats
+{
+    size_t          mappedBytes;    // size of the file mapping, 0 if not mapped
+    unsigned int    loads;          // number of times the face was created
+    long            minorFaults;    // page faults taken while creating faces
+    long            majorFaults;
+    double          seconds;        // total time spent creating faces
+
+    FontLoadStats() : mappedBytes(0), loads(0), minorFaults(0), majorFaults(0), seconds(0)
+    {}
+};
+
+class FontRegistry
+{
+    struct FontEntry
+    {
+        std::string     filename;
+        FT_Face         face;       // null while the face is closed
+        unsigned long   lastUse;    // registry clock at last use, for LRU
+        FontLoadStats   stats;
+
+        // character lookup table, built the first time the face is opened
+        CharMap         charMap;
+
+        // pair kerning adjustments, built alongside the character table
+        KerningTable    kerning;
+
+        // font bytes backing a memory face, if the file is mapped
+        std::shared_ptr<const MappedFile> file;
+    };
+
+    FT_Library                          m_library;
+    std::vector<FontEntry>              m_fonts;    // indexed by handle
+    std::map<std::string, FontHandle>   m_handles;  // filename -> handle
+
+    size_t          m_maxFaces;
+    size_t          m_liveFaces;
+    bool            m_useMapping;
+    unsigned long   m_clock;
+
+    // number of faces created and closed to respect the bound
+    unsigned long   m_facesOpened;
+    unsigned long   m_facesEvicted;
+
+    // creates the face for a font entry, returning false on failure
+    bool OpenFace(FontEntry &entry);
+
+    // closes least recently used faces until another one fits the bound
+    void MakeRoom(FontHandle keep);
+
+    FontRegistry(const FontRegistry &) = delete;
+    FontRegistry &operator=(const FontRegistry &) = delete;
+
+public:
+    explicit FontRegistry(size_t maxFaces = 8);
+    ~FontRegistry();
+
+    FT_Library Library() const          { return m_library; }
+
+    // registers a font file and opens its face, returning its handle; a
+    // file that was registered before returns its existing handle
+    FontHandle Open(const std::string &filename);
+
+    // handle of a registered file, or INVALID_FONT, without opening a face
+    FontHandle Find(const std::string &filename) const;
+
+    // returns the live face for a handle, reopening it if it was evicted,
+    // or null for an invalid handle
+    FT_Face Face(FontHandle handle);
+
+    // closes a font's face early, keeping its mapping, character table and
+    // kerning; Face reopens it when it is next used
+    void CloseFace(FontHandle handle);
+
+    // creates an additional face for a registered font, from its mapping if
+    // it has one, that the caller owns and must release with FT_Done_Face
+    FT_Error NewFace(FontHandle handle, FT_Face *face) const;
+
+    // flat character-to-glyph table of a registered font; it may be unbuilt
+    // (see CharMap::Built) if the face has too many glyphs for it
+    const CharMap &CharacterMap(FontHandle handle) const;
+
+    // pair kerning of a registered font (empty if the font has none)
+    const KerningTable &Kerning(FontHandle handle) const;
+
+    // filename the handle was registered with
+    const std::string &Filename(FontHandle handle) const;
+
+    // font-load statistics for a handle, including its mapping size
+    const FontLoadStats &LoadStats(FontHandle handle) const;
+
+    // chooses between memory faces over a file mapping (the default) and
+    // FreeType's own stream reads, for faces created from now on
+    void SetMemoryMapping(bool enable)  { m_useMapping = enable; }
+    bool MemoryMapping() const          { return m_useMapping; }
+
+    // limits the number of faces kept open at once (at least one)
+    void SetMaxFaces(size_t maxFaces);
+    size_t MaxFaces() const             { return m_maxFaces; }
+
+    // statistics
+    size_t FontCount() const            { return m_fonts.size(); }
+    size_t LiveFaces() const            { return m_liveFaces; }
+    unsigned long FacesOpened() const   { return m_facesOpened; }
+    unsigned long FacesEvicted() const  { return m_facesEvicted; }
+};
+
+// --------------------------------------------------------------------------
+#endif // FONTREGISTRY_H
@@ -0,0 +1,241 @@
+// ==========================================================================
+// Precompiled Glyph Banks
+//
+// A glyph bank is a font's outlines converted offline into one binary file
+// that can be mapped and used directly, with no FreeType calls at run time.
+// See GlyphBank.h for the file layout.
+// ==========================================================================
+
+#include "GlyphBank.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+GlyphBank::GlyphBank()
+    : m_header(0), m_index(0), m_kerning(0), m_blocks(0)
+{}
+
+bool GlyphBank::Open(const string &filename)
+{
+    Close();
+
+    shared_ptr<const MappedFile> file = MappedFile::Open(filename);
+    if (!file) return false;
+
+    const unsigned char *base = file->Data();
+    size_t size = file->Size();
+
+    // check the header and that every table lies inside the file
+    const GlyphBankHeader *header = reinterpret_cast<const GlyphBankHeader *>(base);
+    if (size < sizeof(GlyphBankHeader)
+        || header->magic != GLYPH_BANK_MAGIC
+        || header->version != GLYPH_BANK_VERSION
+        || header->indexOffset % 4 || header->kerningOffset % 4 || header->blockOffset % 4
+        || header->indexOffset + size_t(header->glyphCount) * sizeof(GlyphBankEntry) > size
+        || header->kerningOffset + size_t(header->kerningCount) * sizeof(GlyphBankKerning) > size
+        || header->blockOffset + size_t(header->blockBytes) > size)
+    {
+        cout << "GlyphBank ERROR: " << filename << " is not a valid glyph bank." << endl;
+        return false;
+    }
+
+    const GlyphBankEntry *index = reinterpret_cast<const GlyphBankEntry *>(base + header->indexOffset);
+    const GlyphBankKerning *kerning = reinterpret_cast<const GlyphBankKerning *>(base + header->kerningOffset);
+    const unsigned char *blocks = base + header->blockOffset;
+    // every block must start inside the block area, and the index must be
+    // sorted for the binary search; the blocks themselves are only read,
+    // and checked, when they are first looked up
+    for (unsigned int i = 0; i < header->glyphCount; ++i)
+    {
+        size_t offset = index[i].offset;
+        if (offset % 4 || offset >= header->blockBytes
+            || (i > 0 && index[i].character <= index[i - 1].character))
+        {
+            cout << "GlyphBank ERROR: " << filename << " has a corrupt glyph index." << endl;
+            return false;
+        }
+    }
+
+    for (unsigned int i = 1; i < header->kerningCount; ++i)
+    {
+        const GlyphBankKerning &a = kerning[i - 1], &b = kerning[i];
+        if (a.left > b.left || (a.left == b.left && a.right >= b.right)) {
+            cout << "GlyphBank ERROR: " << filename << " has a corrupt kerning table." << endl;
+            return false;
+        }
+    }
+
+    m_file = file;
+    m_filename = filename;
+    m_checked.assign(header->glyphCount, UNCHECKED);
+    m_header = header;
+    m_index = index;
+    m_kerning = kerning;
+    m_blocks = blocks;
+    return true;
+}
+
+void GlyphBank::Close()
+{
+    m_file.reset();
+    m_checked.clear();
+    m_header = 0;
+    m_index = 0;
+    m_kerning = 0;
+    m_blocks = 0;
+}
+
+// --------------------------------------------------------------------------
+
+MyGlyphView GlyphBank::Glyph(int character) const
+{
+    if (!m_header) return MyGlyphView();
+
+    const GlyphBankEntry *end = m_index + m_header->glyphCount;
+    const GlyphBankEntry *entry = lower_bound(m_index, end, character,
+        [](const GlyphBankEntry &e, int c) { return e.character < c; });
+    if (entry == end || entry->character != character) return MyGlyphView();
+
+    // a block's tables must be consistent and inside the block area, so
+    // readers of the view never leave the mapping (see MyGlyphView::Check);
+    // a corrupt block reads as a missing glyph
+    MyGlyphView glyph(m_blocks + entry->offset);
+    unsigned char &checked = m_checked[entry - m_index];
+    if (checked == UNCHECKED) {
+        checked = glyph.Check(m_header->blockBytes - entry->offset) ? VALID : CORRUPT;
+        if (checked == CORRUPT)
+            cout << "GlyphBank ERROR: " << m_filename << " has a corrupt glyph for character "
+                 << character << "." << endl;
+    }
+    return checked == VALID ? glyph : MyGlyphView();
+}
+
+float GlyphBank::Kerning(int left, int right) const
+{
+    if (!m_header) return 0.f;
+
+    const GlyphBankKerning *end = m_kerning + m_header->kerningCount;
+    const GlyphBankKerning *found = lower_bound(m_kerning, end, make_pair(left, right),
+        [](const GlyphBankKerning &k, const pair<int, int> &p) {
+            return k.left < p.first || (k.left == p.first && k.right < p.second); });
+    if (found == end || found->left != left || found->right != right) return 0.f;
+    return found->value;
+}
+
+void GlyphBank::ExtractString(const string &text, MyGlyphRun &run, float tracking) const
+{
+    static const MyGlyph missing;
+    const size_t missingBytes = MyPackedGlyph::PackedSize(missing);
+
+    run.glyphs.resize(text.size());
+    run.firstUse.clear();
+    run.uniqueCount = 0;
+    run.width = 0.f;
+
+    // first pass: lay out the glyphs and size the storage for each distinct
+    // character, as in GlyphExtractor::ExtractString
+    size_t bytes = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        int character = static_cast<unsigned char>(text[i]);
+        if (i > 0) run.width += Kerning(static_cast<unsigned char>(text[i - 1]), character);
+
+        MyGlyphView glyph = Glyph(character);
+        MyRunGlyph &entry = run.glyphs[i];
+        entry.character = character;
+        entry.offset = run.width;
+        entry.advance = glyph.Advance();
+        run.width += glyph.Advance() + tracking;
+
+        unordered_map<int, unsigned int>::const_iterator it = run.firstUse.find(character);
+        if (it != run.firstUse.end()) {
+            entry.outline = run.glyphs[it->second].outline;
+            continue;
+        }
+        run.firstUse[character] = i;
+        entry.outline = bytes;
+        bytes += glyph.Valid() ? glyph.Size() : missingBytes;
+        ++run.uniqueCount;
+    }
+
+    // second pass: copy each distinct block straight out of the mapping
+    run.storage.resize(bytes);
+    for (unordered_map<int, unsigned int>::const_iterator it = run.firstUse.begin();
+         it != run.firstUse.end(); ++it)
+    {
+        const MyRunGlyph &entry = run.glyphs[it->second];
+        MyGlyphView glyph = Glyph(entry.character);
+        if (glyph.Valid())
+            memcpy(&run.storage[entry.outline], glyph.Data(), glyph.Size());
+        else
+            MyPackedGlyph::PackInto(missing, &run.storage[entry.outline]);
+    }
+}
+
+// --------------------------------------------------------------------------
+
+bool GlyphBank::Write(const string &filename, const GlyphExtractor &extractor,
+                      const vector<int> &characters)
+{
+    // sort and deduplicate the character codes for the index
+    vector<int> codes(characters);
+    sort(codes.begin(), codes.end());
+    codes.erase(unique(codes.begin(), codes.end()), codes.end());
+
+    vector<GlyphBankEntry> index(codes.size());
+    vector<unsigned char> blocks;
+    for (size_t i = 0; i < codes.size(); ++i)
+    {
+        const MyGlyph &glyph = extractor.ExtractGlyph(codes[i]);
+        index[i].character = codes[i];
+        index[i].offset = blocks.size();
+        blocks.resize(blocks.size() + MyPackedGlyph::PackedSize(glyph));
+        MyPackedGlyph::PackInto(glyph, &blocks[index[i].offset]);
+    }
+
+    // every kerned pair of banked characters, in (left, right) order, out
+    // of the pairs the font's kerning table holds
+    vector<pair<int, int> > pairs = extractor.KerningPairs(codes);
+    vector<GlyphBankKerning> kerning;
+    for (size_t p = 0; p < pairs.size(); ++p)
+    {
+        GlyphBankKerning entry = { pairs[p].first, pairs[p].second,
+                                   extractor.Kerning(pairs[p].first, pairs[p].second) };
+        if (entry.value != 0.f) kerning.push_back(entry);
+    }
+
+    GlyphBankHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = GLYPH_BANK_MAGIC;
+    header.version = GLYPH_BANK_VERSION;
+    header.glyphCount = index.size();
+    header.kerningCount = kerning.size();
+    header.indexOffset = sizeof(GlyphBankHeader);
+    header.kerningOffset = header.indexOffset + index.size() * sizeof(GlyphBankEntry);
+    header.blockOffset = header.kerningOffset + kerning.size() * sizeof(GlyphBankKerning);
+    header.blockBytes = blocks.size();
+    header.unitsPerEM = extractor.UnitsPerEM();
+
+    ofstream output(filename.c_str(), ios::binary);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (!index.empty())
+        output.write(reinterpret_cast<const char *>(&index[0]), index.size() * sizeof(GlyphBankEntry));
+    if (!kerning.empty())
+        output.write(reinterpret_cast<const char *>(&kerning[0]), kerning.size() * sizeof(GlyphBankKerning));
+    if (!blocks.empty())
+        output.write(reinterpret_cast<const char *>(&blocks[0]), blocks.size());
+
+    if (!output) {
+        cout << "GlyphBank ERROR: could not write " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------
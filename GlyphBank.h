@@ -0,0 +1,112 @@
+// ==========================================================================
+// Precompiled Glyph Banks
+//
+// A glyph bank is a font's outlines converted offline into one binary file
+// that can be mapped and used directly, with no FreeType calls at run time.
+// The file holds
+//
+//   header      magic, version, glyph and kerning pair counts, table
+//               offsets, units per EM
+//   index       (glyph count) entries of character code and block offset,
+//               sorted by character code
+//   kerning     (pair count) entries of left and right character code and
+//               adjustment in EM units, for every pair of banked characters
+//               the font kerns, sorted by left then right code
+//   blocks      one packed glyph block per entry (see MyPackedGlyph), in
+//               EM units, each 4-byte aligned
+//
+// in native byte order. Opening a bank maps the file and checks the header,
+// the index and the kerning table, so that a truncated or corrupt file is
+// rejected rather than read out of bounds, without touching the blocks.
+// Looking a glyph up is a binary search over the index plus adding the
+// block offset to the mapping's base address; the first lookup of each
+// block also checks its tables (see MyGlyphView::Check), and a corrupt
+// block is reported once and then treated as missing.
+// ==========================================================================
+#ifndef GLYPHBANK_H
+#define GLYPHBANK_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GlyphExtractor.h"
+#include "MappedFile.h"
+
+struct GlyphBankHeader
+{
+    unsigned int    magic;          // GLYPH_BANK_MAGIC
+    unsigned int    version;        // GLYPH_BANK_VERSION
+    unsigned int    glyphCount;
+    unsigned int    indexOffset;    // from the start of the file
+    unsigned int    blockOffset;    // from the start of the file
+    unsigned int    blockBytes;
+    unsigned int    kerningCount;
+    unsigned int    kerningOffset;  // from the start of the file
+    unsigned int    unitsPerEM;     // of the source font, for reference
+    unsigned int    reserved;
+};
+
+struct GlyphBankEntry
+{
+    int             character;
+    unsigned int    offset;         // from the start of the block area
+};
+
+struct GlyphBankKerning
+{
+    int             left;
+    int             right;
+    float           value;          // EM units
+};
+
+const unsigned int GLYPH_BANK_MAGIC = 0x4B4E4247;  // "GBNK" in little endian
+const unsigned int GLYPH_BANK_VERSION = 2;
+
+class GlyphBank
+{
+    std::shared_ptr<const MappedFile>   m_file;
+    const GlyphBankHeader              *m_header;
+    const GlyphBankEntry               *m_index;
+    const GlyphBankKerning             *m_kerning;
+    const unsigned char                *m_blocks;
+    std::string                         m_filename;
+
+    // whether each index entry's block has been checked, and the result
+    enum { UNCHECKED, VALID, CORRUPT };
+    mutable std::vector<unsigned char>  m_checked;
+
+public:
+    GlyphBank();
+
+    // maps a bank file, returning false if it is missing or malformed
+    bool Open(const std::string &filename);
+    void Close();
+    bool IsOpen() const                 { return m_header != 0; }
+
+    size_t GlyphCount() const           { return m_header ? m_header->glyphCount : 0; }
+    size_t KerningCount() const         { return m_header ? m_header->kerningCount : 0; }
+    unsigned int UnitsPerEM() const     { return m_header ? m_header->unitsPerEM : 0; }
+
+    // the packed outline of a character, or an invalid view if the bank
+    // does not contain it or its block is corrupt
+    MyGlyphView Glyph(int character) const;
+
+    // horizontal kerning between two characters, in EM units, as
+    // GlyphExtractor::Kerning gave it when the bank was written
+    float Kerning(int left, int right) const;
+
+    // lays out a string into a glyph run like GlyphExtractor::ExtractString
+    // with kerning enabled, copying outlines out of the mapping, so a run
+    // has the same offsets from a bank as from the font
+    void ExtractString(const std::string &text, MyGlyphRun &run, float tracking = 0.f) const;
+
+    // converts the given characters of the extractor's active font, and the
+    // kerning between them, into a bank file, returning false if it cannot
+    // be written
+    static bool Write(const std::string &filename, const GlyphExtractor &extractor,
+                      const std::vector<int> &characters);
+};
+
+// --------------------------------------------------------------------------
+#endif // GLYPHBANK_H
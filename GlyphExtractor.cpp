@@ -17,6 +17,8 @@
 // ==========================================================================
 
 #include "GlyphExtractor.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 // set this true to print information about the font loaded and glyphs extracted
@@ -27,27 +29,45 @@ using namespace std;
 // --------------------------------------------------------------------------
 
 GlyphExtractor::GlyphExtractor()
-    : m_face(0)
+    : m_active(INVALID_FONT), m_kerning(true), m_cacheHits(0), m_cacheMisses(0),
+      m_ftcManager(0), m_ftcCMaps(0), m_ftcImages(0)
+{}
+
+GlyphExtractor::~GlyphExtractor()
 {
-    // initialize freetype library
-    FT_Error error = FT_Init_FreeType(&m_library);
-    if (error) {
-        cout << "ERROR: FreeType failed to initialize!" << endl;
-    }
+    // cached faces belong to the registry's library, so go first
+    DisableFreeTypeCache();
 }
 
 // --------------------------------------------------------------------------
 
 bool GlyphExtractor::LoadFontFile(const string &filename)
 {
-    FT_Error error = FT_New_Face(m_library, filename.c_str(), 0, &m_face);
+    return SelectFont(OpenFont(filename));
+}
 
-    if (error == FT_Err_Unknown_File_Format) {
-        cout << "Freetype ERROR: unsupported file format in " << filename << endl;
-        return false;
+FontHandle GlyphExtractor::OpenFont(const string &filename)
+{
+    if (!FreeTypeCacheEnabled()) return m_fonts.Open(filename);
+
+    // the cache manager owns the only live faces, so a new font's registry
+    // face is closed once its character table and kerning are built
+    FontHandle handle = m_fonts.Find(filename);
+    if (handle == INVALID_FONT) {
+        handle = m_fonts.Open(filename);
+        m_fonts.CloseFace(handle);
     }
-    else if (error) {
-        cout << "FreeType ERROR: unknown error occurred." << endl;
+    return handle;
+}
+
+bool GlyphExtractor::SelectFont(FontHandle handle)
+{
+    if (handle == INVALID_FONT) return false;
+
+    FontHandle previous = m_active;
+    m_active = handle;
+    if (!ActiveFace()) {
+        m_active = previous;
         return false;
     }
 
@@ -56,24 +76,46 @@ bool GlyphExtractor::LoadFontFile(const string &filename)
     return true;
 }
 
+FT_Face GlyphExtractor::ActiveFace() const
+{
+    if (!FreeTypeCacheEnabled()) return m_fonts.Face(m_active);
+
+    // face ids are font handles offset by one, so that none is null
+    FT_Face face;
+    FTC_FaceID id = reinterpret_cast<FTC_FaceID>(static_cast<size_t>(m_active + 1));
+    if (m_active == INVALID_FONT || FTC_Manager_LookupFace(m_ftcManager, id, &face)) return 0;
+    return face;
+}
+
 // --------------------------------------------------------------------------
 
 void GlyphExtractor::PrintFontInformation() const
 {
-    cout << "Font information for typeface " << m_face->family_name
-         << " (" << m_face->style_name << "):" << endl;
-    cout << "  Number of glyphs: \t" << m_face->num_glyphs << endl;
-    cout << "  Units per EM: \t" << m_face->units_per_EM << endl;
+    FT_Face face = ActiveFace();
+    cout << "Font information for typeface " << face->family_name
+         << " (" << face->style_name << "):" << endl;
+    cout << "  Number of glyphs: \t" << face->num_glyphs << endl;
+    cout << "  Units per EM: \t" << face->units_per_EM << endl;
+
+    const FontLoadStats &stats = m_fonts.LoadStats(m_active);
+    cout << "  Mapped bytes: \t" << stats.mappedBytes << endl;
+    cout << "  Face loads: \t" << stats.loads << " (" << stats.seconds * 1000.0
+         << " ms, " << stats.minorFaults << " minor / " << stats.majorFaults
+         << " major page faults)" << endl;
+
+    const KerningTable &kerning = m_fonts.Kerning(m_active);
+    cout << "  Kerning pairs: \t" << kerning.PairCount() << " (+"
+         << kerning.ClassSubtableCount() << " class subtables)" << endl;
 }
 
-void GlyphExtractor::PrintGlyphInformation(int character) const
+void GlyphExtractor::PrintGlyphInformation(FT_Face face, int character) const
 {
-    FT_Outline &outline = m_face->glyph->outline;
+    FT_Outline &outline = face->glyph->outline;
 
     cout << "Glyph information for character "
          << character << " (" << char(character) << "):" <<  endl;
-    cout << "  Advance: " << m_face->glyph->advance.x
-         << ", " << m_face->glyph->advance.y << endl;
+    cout << "  Advance: " << face->glyph->advance.x
+         << ", " << face->glyph->advance.y << endl;
     cout << "  Number of contours: " << outline.n_contours << endl;
     cout << "  Number of points:   " << outline.n_points << endl;
 
@@ -90,123 +132,611 @@ void GlyphExtractor::PrintGlyphInformation(int character) const
 
 // --------------------------------------------------------------------------
 
-MyGlyph GlyphExtractor::ExtractGlyph(int character) const
+const MyGlyph &GlyphExtractor::ExtractGlyph(int character) const
 {
+    static const MyGlyph empty;
+
     // first check that a font has been loaded
-    if (!m_face) {
+    if (m_active == INVALID_FONT) {
         cout << "GlyphExtractor ERROR: No font loaded!" << endl;
-        return MyGlyph();
+        return empty;
     }
 
-    // look up the glyph index for the given character code
-    int index = FT_Get_Char_Index(m_face, character);
+    // return the cached outline if this character was decoded before
+    GlyphKey key(m_active, character);
+    map<GlyphKey, MyGlyph>::const_iterator it = m_glyphCache.find(key);
+    if (it != m_glyphCache.end()) {
+        ++m_cacheHits;
+        return it->second;
+    }
+
+    // otherwise decode it once and keep it; failures are cached as empty
+    // glyphs too, so a missing character only reports its error once
+    ++m_cacheMisses;
+    return CacheSlot(key) = DecodeGlyph(character);
+}
+
+MyGlyphView GlyphExtractor::ExtractGlyph(int character, MyPackedGlyph &packed) const
+{
+    PackGlyph(character, packed.storage, 0);
+    return packed.View();
+}
+
+MyGlyph &GlyphExtractor::CacheSlot(const GlyphKey &key) const
+{
+    if (FreeTypeCacheEnabled()) {
+        if (m_glyphOrder.size() >= RECENT_GLYPHS) {
+            m_glyphCache.erase(m_glyphOrder.front());
+            m_glyphOrder.pop_front();
+        }
+        m_glyphOrder.push_back(key);
+    }
+    return m_glyphCache[key];
+}
+
+void GlyphExtractor::PackGlyph(int character, vector<unsigned char> &storage, size_t offset) const
+{
+    static const MyGlyph empty;
+    const MyGlyph *glyph = &empty;
+
+    if (m_active == INVALID_FONT)
+        cout << "GlyphExtractor ERROR: No font loaded!" << endl;
+    else {
+        // an outline decoded before is packed from the cache
+        GlyphKey key(m_active, character);
+        map<GlyphKey, MyGlyph>::const_iterator it = m_glyphCache.find(key);
+        if (it != m_glyphCache.end()) {
+            ++m_cacheHits;
+            glyph = &it->second;
+        }
+        else {
+            // otherwise it is decoded once and kept, so the next scene to
+            // use it packs it from the cache. While the FreeType cache
+            // bounds this one, its outline images already make a reload
+            // cheap, so the outline is decoded straight into the block
+            // instead, with no contour allocations, and not kept. Failures
+            // are cached as empty glyphs either way, as in ExtractGlyph
+            ++m_cacheMisses;
+            float advance, em;
+            const FT_Outline *outline = LoadOutline(character, advance, em);
+            if (outline && FreeTypeCacheEnabled()) {
+                DecodeOutline(*outline, advance, em, storage, offset);
+                return;
+            }
+            MyGlyph &slot = CacheSlot(key);
+            if (outline) slot = DecodeOutline(*outline, advance, em);
+            glyph = &slot;
+        }
+    }
+
+    storage.resize(offset + MyPackedGlyph::PackedSize(*glyph));
+    MyPackedGlyph::PackInto(*glyph, &storage[offset]);
+}
+
+void GlyphExtractor::ExtractString(const string &text, MyGlyphRun &run, float tracking) const
+{
+    vector<int> characters(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+        characters[i] = static_cast<unsigned char>(text[i]);
+    ExtractString(characters.empty() ? 0 : &characters[0], characters.size(), run, tracking);
+}
+
+void GlyphExtractor::ExtractString(const int *characters, size_t count, MyGlyphRun &run,
+                                   float tracking) const
+{
+    run.glyphs.resize(count);
+    run.storage.clear();
+    run.firstUse.clear();
+    run.uniqueCount = 0;
+    run.width = 0.f;
+
+    // lay out the glyphs, packing each distinct character's outline behind
+    // the previous ones when it is first met; repeated characters point at
+    // the first one's block
+    const KerningTable &kerning = m_fonts.Kerning(m_active);
+    bool kern = m_kerning && !kerning.Empty();
+    unsigned int previous = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (kern) {
+            unsigned int index = GlyphIndex(characters[i]);
+            if (i > 0) run.width += kerning.Lookup(previous, index);
+            previous = index;
+        }
+
+        MyRunGlyph &entry = run.glyphs[i];
+        entry.character = characters[i];
+        entry.offset = run.width;
+
+        unordered_map<int, unsigned int>::const_iterator it = run.firstUse.find(characters[i]);
+        if (it != run.firstUse.end()) {
+            entry.outline = run.glyphs[it->second].outline;
+            entry.advance = run.glyphs[it->second].advance;
+        }
+        else {
+            run.firstUse[characters[i]] = i;
+            entry.outline = run.storage.size();
+            PackGlyph(characters[i], run.storage, entry.outline);
+            entry.advance = MyGlyphView(&run.storage[entry.outline]).Advance();
+            ++run.uniqueCount;
+        }
+        run.width += entry.advance + tracking;
+    }
+}
+
+// --------------------------------------------------------------------------
+// FreeType cache subsystem backend
+
+FT_Error GlyphExtractor::RequestFace(FTC_FaceID id, FT_Library, FT_Pointer data, FT_Face *face)
+{
+    const FontRegistry *fonts = static_cast<const FontRegistry *>(data);
+    FontHandle handle = static_cast<FontHandle>(reinterpret_cast<size_t>(id)) - 1;
+    return fonts->NewFace(handle, face);
+}
+
+bool GlyphExtractor::EnableFreeTypeCache(unsigned long maxBytes, unsigned int maxFaces)
+{
+    DisableFreeTypeCache();
+    if (!m_fonts.Library()) return false;
+
+    // one size per face, the small one LoadOutline asks for, so switching
+    // fonts never recreates a size
+    FT_Error error = FTC_Manager_New(m_fonts.Library(), maxFaces, maxFaces, maxBytes,
+                                     RequestFace, &m_fonts, &m_ftcManager);
+    if (!error) error = FTC_CMapCache_New(m_ftcManager, &m_ftcCMaps);
+    if (!error) error = FTC_ImageCache_New(m_ftcManager, &m_ftcImages);
+    if (error) {
+        cout << "FreeType ERROR: could not create the glyph cache." << endl;
+        DisableFreeTypeCache();
+        return false;
+    }
+
+    // the manager's faces replace the registry's, and the outline cache
+    // starts over within its bound
+    for (size_t i = 0; i < m_fonts.FontCount(); ++i)
+        m_fonts.CloseFace(FontHandle(i));
+    ClearCache();
+    return true;
+}
+
+void GlyphExtractor::DisableFreeTypeCache()
+{
+    if (!m_ftcManager) return;
+
+    // the manager owns its caches and every face it requested; outlines
+    // already cached stay, and are no longer evicted
+    FTC_Manager_Done(m_ftcManager);
+    m_ftcManager = 0;
+    m_ftcCMaps = 0;
+    m_ftcImages = 0;
+    m_glyphOrder.clear();
+}
+
+// --------------------------------------------------------------------------
+
+float GlyphExtractor::Kerning(int left, int right) const
+{
+    const KerningTable &kerning = m_fonts.Kerning(m_active);
+    if (kerning.Empty()) return 0.f;
+    return kerning.Lookup(GlyphIndex(left), GlyphIndex(right));
+}
+
+vector<pair<int, int> > GlyphExtractor::KerningPairs(const vector<int> &characters) const
+{
+    vector<pair<int, int> > result;
+    const KerningTable &kerning = m_fonts.Kerning(m_active);
+    if (kerning.Empty()) return result;
+
+    // the characters of each glyph, since several can share one
+    unordered_map<unsigned int, vector<int> > byGlyph;
+    for (size_t i = 0; i < characters.size(); ++i)
+        byGlyph[GlyphIndex(characters[i])].push_back(characters[i]);
+    vector<unsigned int> glyphs;
+    for (unordered_map<unsigned int, vector<int> >::const_iterator it = byGlyph.begin();
+         it != byGlyph.end(); ++it)
+        glyphs.push_back(it->first);
+
+    vector<pair<unsigned int, unsigned int> > pairs;
+    kerning.Pairs(glyphs, pairs);
+    for (size_t p = 0; p < pairs.size(); ++p)
+    {
+        const vector<int> &left = byGlyph[pairs[p].first], &right = byGlyph[pairs[p].second];
+        for (size_t l = 0; l < left.size(); ++l)
+            for (size_t r = 0; r < right.size(); ++r)
+                result.push_back(make_pair(left[l], right[r]));
+    }
+    sort(result.begin(), result.end());
+    result.erase(unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+unsigned int GlyphExtractor::GlyphIndex(int character) const
+{
+    // look up the glyph index for the given character code, in the charmap
+    // cache when it is enabled, or else in the font's flat table when it has one
+    if (FreeTypeCacheEnabled()) {
+        FTC_FaceID id = reinterpret_cast<FTC_FaceID>(static_cast<size_t>(m_active + 1));
+        return FTC_CMapCache_Lookup(m_ftcCMaps, id, -1, character);
+    }
+    const CharMap &charMap = m_fonts.CharacterMap(m_active);
+    if (charMap.Built()) return charMap.Lookup(character);
+    FT_Face face = m_fonts.Face(m_active);
+    return face ? FT_Get_Char_Index(face, character) : 0;
+}
+
+unsigned int GlyphExtractor::UnitsPerEM() const
+{
+    FT_Face face = ActiveFace();
+    return face ? face->units_per_EM : 0;
+}
+
+vector<int> GlyphExtractor::CharacterSet() const
+{
+    vector<int> characters;
+    FT_Face face = ActiveFace();
+    if (!face) return characters;
+
+    FT_UInt index;
+    FT_ULong code = FT_Get_First_Char(face, &index);
+    while (index != 0) {
+        characters.push_back(code);
+        code = FT_Get_Next_Char(face, code, &index);
+    }
+    return characters;
+}
+
+void GlyphExtractor::ClearCache()
+{
+    m_glyphCache.clear();
+    m_glyphOrder.clear();
+    m_cacheHits = m_cacheMisses = 0;
+}
+
+// --------------------------------------------------------------------------
+
+const FT_Outline *GlyphExtractor::LoadOutline(int character, float &advance, float &em) const
+{
+    unsigned int index = GlyphIndex(character);
+    const FT_Outline *outline = 0;
 
-    // load the glyph for the given character into the face glyph slot,
-    // keeping the outline in original font units
-    FT_Error error = FT_Load_Glyph(m_face, index, FT_LOAD_NO_SCALE);
-    if (error || m_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+    if (FreeTypeCacheEnabled())
+    {
+        // outlines stay in font units, so the scaler only selects the face;
+        // its size is a small one, cheap to create and shared by every glyph
+        FTC_ScalerRec scaler;
+        scaler.face_id = reinterpret_cast<FTC_FaceID>(static_cast<size_t>(m_active + 1));
+        scaler.width = scaler.height = 16;
+        scaler.pixel = 1;
+        scaler.x_res = scaler.y_res = 0;
+
+        FT_Face face;
+        FT_Glyph image;
+        if (!FTC_Manager_LookupFace(m_ftcManager, scaler.face_id, &face) &&
+            !FTC_ImageCache_LookupScaler(m_ftcImages, &scaler, FT_LOAD_NO_SCALE, index, &image, 0) &&
+            image->format == FT_GLYPH_FORMAT_OUTLINE) {
+            // glyph image advances are 16.16 fixed point converted from the
+            // slot's 26.6 advance, which FT_LOAD_NO_SCALE leaves in font units
+            outline = &reinterpret_cast<FT_OutlineGlyph>(image)->outline;
+            advance = image->advance.x / 1024.f;
+            em = face->units_per_EM;
+        }
+    }
+    else
     {
+        // load the glyph for the given character into the face glyph slot,
+        // keeping the outline in original font units. The registry may have
+        // closed the face since it was selected, so fetch it again
+        FT_Face face = m_fonts.Face(m_active);
+        if (face && !FT_Load_Glyph(face, index, FT_LOAD_NO_SCALE) &&
+            face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+            if (DEBUG_PRINT) PrintGlyphInformation(face, character);
+            outline = &face->glyph->outline;
+            advance = face->glyph->advance.x;
+            em = face->units_per_EM;
+        }
+    }
+
+    if (!outline)
         cout << "FreeType ERROR: Could not find glyph outline for character "
              << character << " (" << char(character) << ")" <<  endl;
-        return MyGlyph();
+    return outline;
+}
+
+MyGlyph GlyphExtractor::DecodeGlyph(int character) const
+{
+    float advance, em;
+    const FT_Outline *outline = LoadOutline(character, advance, em);
+    return outline ? DecodeOutline(*outline, advance, em) : MyGlyph();
+}
+
+namespace {
+    // round a byte count up to the next multiple of four
+    size_t Align4(size_t bytes) { return (bytes + 3) & ~size_t(3); }
+
+    size_t BlockSize(size_t contours, size_t segments, size_t points)
+    {
+        return sizeof(MyPackedHeader)
+             + sizeof(unsigned int) * (contours + 1 + segments)
+             + sizeof(float) * 2 * points
+             + Align4(segments);
     }
 
-    if (DEBUG_PRINT) PrintGlyphInformation(character);
+    // count the segments and stored points of a glyph
+    void CountGlyph(const MyGlyph &glyph, unsigned int &segments, unsigned int &points)
+    {
+        segments = points = 0;
+        for (size_t c = 0; c < glyph.contours.size(); ++c)
+        {
+            const MyContour &contour = glyph.contours[c];
+            if (contour.empty()) continue;
+            segments += contour.size();
+            points += 1;
+            for (size_t s = 0; s < contour.size(); ++s)
+                points += contour[s].degree;
+        }
+    }
 
-    // create a new glyph structure to populate with this character outline
-    FT_Outline &outline = m_face->glyph->outline;
-    float em = m_face->units_per_EM;
-    MyGlyph glyph(m_face->glyph->advance.x / em);
+    // Receivers of the contours and segments of an outline, in order: one
+    // builds a MyGlyph, one counts what a packed block needs, and one writes
+    // the block.
+    struct GlyphBuilder
+    {
+        MyGlyph &glyph;
 
-    // current point index
-    int begin = 0;
+        GlyphBuilder(MyGlyph &glyph) : glyph(glyph)
+        {}
 
-    // iterate through the outline's contours
-    for (int c = 0; c < outline.n_contours; ++c)
+        void BeginContour()                         { glyph.contours.push_back(MyContour()); }
+        void Segment(const MySegment &segment)      { glyph.contours.back().push_back(segment); }
+    };
+
+    struct OutlineCounter
     {
-        MyContour contour;
+        unsigned int contours, segments, points;
+        bool first;
+
+        OutlineCounter() : contours(0), segments(0), points(0), first(false)
+        {}
 
-        // iterate through current contour's points
-        int end = outline.contours[c];
-        for (int p = begin; p <= end; ++p)
+        void BeginContour()                         { ++contours; first = true; }
+        void Segment(const MySegment &segment)
         {
-            // index for next point, q
-            int q = p+1;
-            if (q > end) q = begin;
+            points += segment.degree + (first ? 1 : 0);
+            first = false;
+            ++segments;
+        }
+    };
 
-            // retrieve position vectors
-            FT_Vector r_p = outline.points[p];
-            FT_Vector r_q = outline.points[q];
+    // each contour writes its start point once, then the remaining
+    // [degree] points of every segment
+    class BlockWriter
+    {
+        unsigned int   *m_contourSegments;
+        unsigned int   *m_segmentPoints;
+        float          *m_xy;
+        unsigned char  *m_degrees;
+        unsigned int    m_contour, m_segment, m_point;
+        bool            m_first;
+
+    public:
+        BlockWriter(unsigned char *block, float advance, unsigned int contours,
+                    unsigned int segments, unsigned int points)
+            : m_contour(0), m_segment(0), m_point(0), m_first(false)
+        {
+            MyPackedHeader header;
+            header.advance = advance;
+            header.contourCount = contours;
+            header.segmentCount = segments;
+            header.pointCount = points;
+            memcpy(block, &header, sizeof(header));
+
+            MyGlyphView view(block);
+            m_contourSegments = const_cast<unsigned int *>(view.ContourSegments());
+            m_segmentPoints = const_cast<unsigned int *>(view.SegmentPoints());
+            m_xy = const_cast<float *>(view.Points());
+            m_degrees = const_cast<unsigned char *>(view.SegmentDegrees());
+        }
 
-            // create a segment to store control points
-            MySegment segment;
+        void BeginContour()
+        {
+            m_contourSegments[m_contour++] = m_segment;
+            m_first = true;
+        }
 
-            if (outline.tags[p] & 1) {
-                segment.x[0] = r_p.x / em;
-                segment.y[0] = r_p.y / em;
+        void Segment(const MySegment &segment)
+        {
+            if (m_first) {
+                m_xy[2*m_point] = segment.x[0];
+                m_xy[2*m_point+1] = segment.y[0];
+                ++m_point;
+                m_first = false;
             }
-            else {
-                segment.x[0] = 0.5f * (r_p.x + r_q.x) / em;
-                segment.y[0] = 0.5f * (r_p.y + r_q.y) / em;
+            m_segmentPoints[m_segment] = m_point - 1;
+            m_degrees[m_segment++] = segment.degree;
+            for (unsigned int k = 1; k <= segment.degree; ++k, ++m_point) {
+                m_xy[2*m_point] = segment.x[k];
+                m_xy[2*m_point+1] = segment.y[k];
             }
+        }
 
-            // set degree of segment based on what the next point is
-            if (outline.tags[q] & 1)
-            {
-                // next point is on curve, so this is a line segment
-                segment.degree = 1;
-                segment.x[1] = r_q.x / em;
-                segment.y[1] = r_q.y / em;
-            }
-            else if (outline.tags[q] & 2)
+        // closes the contour table and zeroes the padding after the degrees
+        void Finish()
+        {
+            m_contourSegments[m_contour] = m_segment;
+            memset(m_degrees + m_segment, 0, Align4(m_segment) - m_segment);
+        }
+    };
+
+    // passes the contours of a FreeType outline in font units to a receiver
+    // as segments in EM units
+    template <class Receiver>
+    void WalkOutline(const FT_Outline &outline, float em, Receiver &receiver)
+    {
+        // current point index
+        int begin = 0;
+
+        // iterate through the outline's contours
+        for (int c = 0; c < outline.n_contours; ++c)
+        {
+            receiver.BeginContour();
+
+            // iterate through current contour's points
+            int end = outline.contours[c];
+            for (int p = begin; p <= end; ++p)
             {
-                // next point is third degree, so this is a cubic segment
-                segment.degree = 3;
-                for (int i = 0; i < 3; ++i)
+                // index for next point, q
+                int q = p+1;
+                if (q > end) q = begin;
+
+                // retrieve position vectors
+                FT_Vector r_p = outline.points[p];
+                FT_Vector r_q = outline.points[q];
+
+                // create a segment to store control points
+                MySegment segment;
+
+                if (outline.tags[p] & 1) {
+                    segment.x[0] = r_p.x / em;
+                    segment.y[0] = r_p.y / em;
+                }
+                else {
+                    segment.x[0] = 0.5f * (r_p.x + r_q.x) / em;
+                    segment.y[0] = 0.5f * (r_p.y + r_q.y) / em;
+                }
+
+                // set degree of segment based on what the next point is
+                if (outline.tags[q] & 1)
                 {
-                    segment.x[1+i] = r_q.x / em;
-                    segment.y[1+i] = r_q.y / em;
-                    if (++q > end) q = begin;
-                    r_q = outline.points[q];
+                    // next point is on curve, so this is a line segment
+                    segment.degree = 1;
+                    segment.x[1] = r_q.x / em;
+                    segment.y[1] = r_q.y / em;
                 }
-                p += 2;
-            }
-            else
-            {
-                // next point is second degree, so this is a quadratic segment
-                segment.degree = 2;
-                segment.x[1] = r_q.x / em;
-                segment.y[1] = r_q.y / em;
-
-                // advance q
-                if (++q > end) q = begin;
-                r_q = outline.points[q];
-
-                // if the next point is on curve, store and advance p
-                if (outline.tags[q] & 1) {
-                    segment.x[2] = r_q.x / em;
-                    segment.y[2] = r_q.y / em;
-                    ++p;
+                else if (outline.tags[q] & 2)
+                {
+                    // next point is third degree, so this is a cubic segment
+                    segment.degree = 3;
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        segment.x[1+i] = r_q.x / em;
+                        segment.y[1+i] = r_q.y / em;
+                        if (++q > end) q = begin;
+                        r_q = outline.points[q];
+                    }
+                    p += 2;
                 }
-                // otherwise store the midpoint
-                else {
-                    segment.x[2] = 0.5f * (segment.x[1] + r_q.x / em);
-                    segment.y[2] = 0.5f * (segment.y[1] + r_q.y / em);
+                else
+                {
+                    // next point is second degree, so this is a quadratic segment
+                    segment.degree = 2;
+                    segment.x[1] = r_q.x / em;
+                    segment.y[1] = r_q.y / em;
+
+                    // advance q
+                    if (++q > end) q = begin;
+                    r_q = outline.points[q];
+
+                    // if the next point is on curve, store and advance p
+                    if (outline.tags[q] & 1) {
+                        segment.x[2] = r_q.x / em;
+                        segment.y[2] = r_q.y / em;
+                        ++p;
+                    }
+                    // otherwise store the midpoint
+                    else {
+                        segment.x[2] = 0.5f * (segment.x[1] + r_q.x / em);
+                        segment.y[2] = 0.5f * (segment.y[1] + r_q.y / em);
+                    }
                 }
+
+                // pass the segment on
+                receiver.Segment(segment);
             }
 
-            // add segment to contour
-            contour.push_back(segment);
+            // set beginning of next contour
+            begin = end + 1;
+
         }
+    }
+}
+
+MyGlyph GlyphExtractor::DecodeOutline(const FT_Outline &outline, float advance, float em)
+{
+    // create a new glyph structure to populate with this character outline
+    MyGlyph glyph(advance / em);
+    GlyphBuilder builder(glyph);
+    WalkOutline(outline, em, builder);
+    return glyph;
+}
+
+void GlyphExtractor::DecodeOutline(const FT_Outline &outline, float advance, float em,
+                                   vector<unsigned char> &storage, size_t offset)
+{
+    // one walk sizes the block and a second fills it, so the outline goes
+    // into a single allocation without building any contours
+    OutlineCounter counter;
+    WalkOutline(outline, em, counter);
+    storage.resize(offset + BlockSize(counter.contours, counter.segments, counter.points));
+
+    BlockWriter writer(&storage[offset], advance / em, counter.contours, counter.segments, counter.points);
+    WalkOutline(outline, em, writer);
+    writer.Finish();
+}
+
+// --------------------------------------------------------------------------
+// Packed glyph support
+
+size_t MyGlyphView::Size() const
+{
+    if (!m_data) return 0;
+    return BlockSize(ContourCount(), SegmentCount(), PointCount());
+}
+
+bool MyGlyphView::Check(size_t bytes) const
+{
+    // the header, then the tables it sizes, must fit
+    if (!m_data || bytes < sizeof(MyPackedHeader) || Size() > bytes) return false;
+
+    const unsigned int *contours = ContourSegments();
+    if (contours[0] != 0 || contours[ContourCount()] != SegmentCount()) return false;
+    for (unsigned int c = 0; c < ContourCount(); ++c)
+        if (contours[c] > contours[c + 1]) return false;
+
+    const unsigned int *points = SegmentPoints();
+    const unsigned char *degrees = SegmentDegrees();
+    for (unsigned int s = 0; s < SegmentCount(); ++s)
+        if (degrees[s] > 3 || size_t(points[s]) + degrees[s] >= PointCount()) return false;
+    return true;
+}
 
-        // set beginning of next contour
-        begin = end + 1;
+size_t MyPackedGlyph::PackedSize(const MyGlyph &glyph)
+{
+    unsigned int segments, points;
+    CountGlyph(glyph, segments, points);
+    return BlockSize(glyph.contours.size(), segments, points);
+}
 
-        // add contour to glyph
-        glyph.contours.push_back(contour);
+void MyPackedGlyph::PackInto(const MyGlyph &glyph, unsigned char *block)
+{
+    unsigned int segments, points;
+    CountGlyph(glyph, segments, points);
+
+    BlockWriter writer(block, glyph.advance, glyph.contours.size(), segments, points);
+    for (size_t c = 0; c < glyph.contours.size(); ++c)
+    {
+        const MyContour &contour = glyph.contours[c];
+        writer.BeginContour();
+        for (size_t s = 0; s < contour.size(); ++s)
+            writer.Segment(contour[s]);
     }
+    writer.Finish();
+}
 
-    return glyph;
+void MyPackedGlyph::Pack(const MyGlyph &glyph)
+{
+    storage.resize(PackedSize(glyph));
+    PackInto(glyph, &storage[0]);
 }
 
 // --------------------------------------------------------------------------
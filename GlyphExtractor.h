@@ -9,6 +9,12 @@
 //  - A contour consists of one or more segments (stored as std::vector)
 //  - A segment is either a straight line, quadratic Bezier, or cubic Bezier
 //
+// A glyph can also be packed into a single contiguous block (MyPackedGlyph)
+// holding one flat point array plus segment and contour tables, which is
+// read through a lightweight MyGlyphView. A whole string is extracted into a
+// MyGlyphRun, which lays out the characters and stores each distinct outline
+// once as a packed block.
+//
 // You may use this code (or not) however you see fit for your work.
 //
 // Author:  Sonny Chan
@@ -18,11 +24,15 @@
 #ifndef GLYPHEXTRACTOR_H
 #define GLYPHEXTRACTOR_H
 
+#include <deque>
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include "FontRegistry.h"
+#include FT_CACHE_H
 
 // --------------------------------------------------------------------------
 // DATA STRUCTURES: Segment, Contour, and Glyph
@@ -57,27 +67,270 @@ struct MyGlyph
     {}
 };
 
+// --------------------------------------------------------------------------
+// PACKED GLYPHS: the same outline stored in a single allocation
+//
+// Segments in a contour share their end points, so a contour of segments with
+// degrees d0, d1, ... is stored as 1 + d0 + d1 + ... points, the last of which
+// closes the contour. Segment s uses points [first, first + degree] where first
+// is its entry in the segment point table. The block layout is
+//
+//   header      advance, contour count, segment count, point count
+//   contours    (contour count + 1) indices of each contour's first segment
+//   segments    (segment count) indices of each segment's first point
+//   points      (point count) interleaved x, y pairs in EM units
+//   degrees     (segment count) bytes, padded to a multiple of four
+//
+// Every field is 4-byte aligned and position independent, so a block can be
+// copied or mapped anywhere and read in place.
+
+struct MyPackedHeader
+{
+    float           advance;
+    unsigned int    contourCount;
+    unsigned int    segmentCount;
+    unsigned int    pointCount;
+};
+
+// A read-only view over a packed glyph block.
+class MyGlyphView
+{
+    const unsigned char *m_data;
+
+    const MyPackedHeader &Header() const
+    { return *reinterpret_cast<const MyPackedHeader *>(m_data); }
+
+public:
+    MyGlyphView(const unsigned char *data = 0) : m_data(data)
+    {}
+
+    bool Valid() const                  { return m_data != 0; }
+    const unsigned char *Data() const   { return m_data; }
+
+    float Advance() const               { return m_data ? Header().advance : 0.f; }
+    unsigned int ContourCount() const   { return m_data ? Header().contourCount : 0; }
+    unsigned int SegmentCount() const   { return m_data ? Header().segmentCount : 0; }
+    unsigned int PointCount() const     { return m_data ? Header().pointCount : 0; }
+
+    // segments of contour c are [ContourSegments()[c], ContourSegments()[c+1])
+    const unsigned int *ContourSegments() const
+    { return reinterpret_cast<const unsigned int *>(m_data + sizeof(MyPackedHeader)); }
+
+    const unsigned int *SegmentPoints() const
+    { return ContourSegments() + ContourCount() + 1; }
+
+    const float *Points() const
+    { return reinterpret_cast<const float *>(SegmentPoints() + SegmentCount()); }
+
+    const unsigned char *SegmentDegrees() const
+    { return reinterpret_cast<const unsigned char *>(Points() + 2 * PointCount()); }
+
+    // total size of the block, in bytes
+    size_t Size() const;
+
+    // whether the block fits in [bytes] and its tables are consistent:
+    // contour ranges ascend from 0 to the segment count, and every segment
+    // has a degree of at most 3 and its points inside the point array. Blocks
+    // read from untrusted storage must pass this before they are used
+    bool Check(size_t bytes) const;
+};
+
+// Owns the storage for one packed glyph block.
+struct MyPackedGlyph
+{
+    std::vector<unsigned char> storage;
+
+    // bytes needed to pack the given glyph
+    static size_t PackedSize(const MyGlyph &glyph);
+
+    // writes the glyph into a block of PackedSize(glyph) bytes
+    static void PackInto(const MyGlyph &glyph, unsigned char *block);
+
+    // packs a glyph, reusing the existing storage where possible
+    void Pack(const MyGlyph &glyph);
+
+    MyGlyphView View() const
+    { return MyGlyphView(storage.empty() ? 0 : &storage[0]); }
+};
+
+// --------------------------------------------------------------------------
+// GLYPH RUNS: a laid-out string of glyphs sharing one outline buffer
+
+// One character of a run: where it sits on the baseline, and which of the
+// run's unique outlines it is drawn with.
+struct MyRunGlyph
+{
+    int             character;
+    float           offset;     // pen position from the start of the run, EM units
+    float           advance;    // advance width of this glyph, EM units
+    unsigned int    outline;    // byte offset of its packed block in the run storage
+};
+
+struct MyGlyphRun
+{
+    // one entry per character, in string order
+    std::vector<MyRunGlyph> glyphs;
+
+    // packed blocks of each distinct character, back to back
+    std::vector<unsigned char> storage;
+
+    // number of distinct outlines in storage
+    unsigned int uniqueCount;
+
+    // total advance of the run, EM units
+    float width;
+
+    // first glyph index of each distinct character, used while building
+    std::unordered_map<int, unsigned int> firstUse;
+
+    MyGlyphRun() : uniqueCount(0), width(0)
+    {}
+
+    size_t Size() const                 { return glyphs.size(); }
+
+    // packed outline of the i-th glyph
+    MyGlyphView Outline(size_t i) const
+    { return MyGlyphView(&storage[0] + glyphs[i].outline); }
+};
+
 // --------------------------------------------------------------------------
 // This class encapsulates functionality required to load a font file from
 // disk and retrieve glyph outlines for characters from the font.
 
 class GlyphExtractor
 {
-    FT_Library  m_library;
-    FT_Face     m_face;
+    // fonts opened by this extractor, and the active one
+    mutable FontRegistry    m_fonts;
+    FontHandle              m_active;
+
+    // whether ExtractString applies the active font's pair kerning
+    bool                    m_kerning;
+
+    // outlines already decoded, keyed by (font, character), and the number
+    // of extractions served from / added to this cache. With the FreeType
+    // cache enabled it only keeps the RECENT_GLYPHS latest outlines, oldest
+    // first in m_glyphOrder
+    typedef std::pair<FontHandle, int> GlyphKey;
+    mutable std::map<GlyphKey, MyGlyph> m_glyphCache;
+    mutable std::deque<GlyphKey> m_glyphOrder;
+    mutable unsigned long m_cacheHits;
+    mutable unsigned long m_cacheMisses;
+
+    // optional FreeType cache subsystem backend: faces, charmaps and outline
+    // images are then owned by an FTC_Manager within a fixed memory budget,
+    // and the registry keeps no faces open
+    FTC_Manager         m_ftcManager;
+    FTC_CMapCache       m_ftcCMaps;
+    FTC_ImageCache      m_ftcImages;
+
+    static FT_Error RequestFace(FTC_FaceID id, FT_Library, FT_Pointer data, FT_Face *face);
+
+    // the active font's face, from the cache manager when it is enabled; it
+    // stays valid until the next face or glyph lookup
+    FT_Face ActiveFace() const;
+
+    // glyph index of a character in the active font
+    unsigned int GlyphIndex(int character) const;
+
+    // adds an empty slot for an outline to the cache, evicting the oldest
+    // entry if the cache is bounded and full
+    MyGlyph &CacheSlot(const GlyphKey &key) const;
+
+    // packs a character's outline into [storage] at [offset], resizing the
+    // storage to fit, from the cache; a missing outline is decoded into the
+    // cache first, or with the FreeType cache enabled straight into the
+    // block
+    void PackGlyph(int character, std::vector<unsigned char> &storage, size_t offset) const;
 
     // private methods to print font/glyph info, for debugging
     void PrintFontInformation() const;
-    void PrintGlyphInformation(int character) const;
+    void PrintGlyphInformation(FT_Face face, int character) const;
+
+    // loads the outline for a character from the current face, or from the
+    // FreeType cache when it is enabled, returning its advance and EM size
+    // in font units; it stays valid until the next load
+    const FT_Outline *LoadOutline(int character, float &advance, float &em) const;
+    MyGlyph DecodeGlyph(int character) const;
+
+    // converts a FreeType outline in font units into a MyGlyph, or packs it
+    // straight into [storage] at [offset], resizing the storage to fit
+    static MyGlyph DecodeOutline(const FT_Outline &outline, float advance, float em);
+    static void DecodeOutline(const FT_Outline &outline, float advance, float em,
+                              std::vector<unsigned char> &storage, size_t offset);
 
 public:
+    // outlines kept by the cache while the FreeType cache is enabled
+    static const size_t RECENT_GLYPHS = 256;
+
     GlyphExtractor();
+    ~GlyphExtractor();
 
-    // call this method first to load a font file
+    // call this method first to load a font file; a file that was loaded
+    // before is reused rather than parsed again
     bool LoadFontFile(const std::string &filename);
 
-    // this method retrieves a (possibly composite) glyph for the given character
-    MyGlyph ExtractGlyph(int character) const;
+    // registers a font without making it active, and switches the active
+    // font to one returned by OpenFont (or LoadFontFile's ActiveFont)
+    FontHandle OpenFont(const std::string &filename);
+    bool SelectFont(FontHandle handle);
+    FontHandle ActiveFont() const       { return m_active; }
+
+    // the registry holding every font this extractor has opened
+    FontRegistry &Fonts()               { return m_fonts; }
+
+    // this method retrieves a (possibly composite) glyph for the given
+    // character; repeated requests on the same face are served from a cache.
+    // The result stays valid until the cache is cleared or, with the
+    // FreeType cache enabled, until RECENT_GLYPHS other outlines have been
+    // decoded.
+    const MyGlyph &ExtractGlyph(int character) const;
+
+    // retrieves a glyph into a packed block, returning a view of the block;
+    // it is cached as ExtractGlyph caches it, except that with the FreeType
+    // cache enabled an outline not already cached is decoded directly into
+    // the block
+    MyGlyphView ExtractGlyph(int character, MyPackedGlyph &packed) const;
+
+    // lays out a string (or a span of character codes) into a glyph run,
+    // adding [tracking] EM units after every advance and, unless disabled,
+    // the font's kerning between each pair; each distinct outline is packed
+    // once, as it is first met, and the run's buffers keep their capacity
+    // when the run is reused
+    void ExtractString(const std::string &text, MyGlyphRun &run, float tracking = 0.f) const;
+    void ExtractString(const int *characters, size_t count, MyGlyphRun &run,
+                       float tracking = 0.f) const;
+
+    // horizontal kerning between two characters of the active font, in EM
+    // units, and a switch for applying it in ExtractString (on by default)
+    float Kerning(int left, int right) const;
+    void SetKerning(bool enable)        { m_kerning = enable; }
+
+    // the pairs of [characters] the active font may kern, in ascending
+    // order, taken from the pairs its kerning table holds (see
+    // KerningTable::Pairs) rather than by trying every combination
+    std::vector<std::pair<int, int> > KerningPairs(const std::vector<int> &characters) const;
+    bool KerningEnabled() const         { return m_kerning; }
+
+    // EM size of the active font in font units (0 if none is loaded)
+    unsigned int UnitsPerEM() const;
+
+    // character codes the active font maps to a glyph, in ascending order
+    std::vector<int> CharacterSet() const;
+
+    // routes face, charmap and outline lookups through FreeType's cache
+    // subsystem, keeping at most [maxFaces] faces and about [maxBytes] of
+    // outline images alive across all fonts, and bounds this class's own
+    // outline cache to RECENT_GLYPHS entries. Enabling it clears that cache
+    // and closes the registry's faces
+    bool EnableFreeTypeCache(unsigned long maxBytes = 1 << 20, unsigned int maxFaces = 4);
+    void DisableFreeTypeCache();
+    bool FreeTypeCacheEnabled() const   { return m_ftcManager != 0; }
+
+    // glyph cache statistics, and a method to discard all cached outlines
+    unsigned long CacheHits() const     { return m_cacheHits; }
+    unsigned long CacheMisses() const   { return m_cacheMisses; }
+    size_t CacheSize() const            { return m_glyphCache.size(); }
+    void ClearCache();
 };
 
 // --------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+// ==========================================================================
+// Parallel Glyph Extraction
+//
+// A GlyphExtractor is not safe to share between threads: decoding a glyph
+// goes through its face's single glyph slot. A GlyphExtractorPool instead
+// runs a fixed set of worker threads, each owning a complete GlyphExtractor
+// (its own FT_Library and FT_Face) over the same shared font mapping, and
+// splits the characters of a request between them. Results are written back
+// in request order, so callers see the same output as a serial loop.
+// ==========================================================================
+
+#include "GlyphExtractorPool.h"
+#include <algorithm>
+
+using namespace std;
+
+// number of characters a worker claims at a time
+static const size_t CHUNK_SIZE = 16;
+
+// --------------------------------------------------------------------------
+
+GlyphExtractorPool::GlyphExtractorPool(unsigned int threads)
+    : m_characters(0), m_count(0), m_glyphs(0), m_next(0),
+      m_generation(0), m_busy(0), m_quit(false)
+{
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    for (unsigned int i = 0; i < threads; ++i)
+        m_extractors.push_back(unique_ptr<GlyphExtractor>(new GlyphExtractor));
+    for (unsigned int i = 0; i < threads; ++i)
+        m_threads.push_back(thread(&GlyphExtractorPool::WorkerLoop, this, i));
+}
+
+GlyphExtractorPool::~GlyphExtractorPool()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+}
+
+// --------------------------------------------------------------------------
+
+void GlyphExtractorPool::WorkerLoop(unsigned int worker)
+{
+    GlyphExtractor &extractor = *m_extractors[worker];
+    unsigned long seen = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m_lock);
+            m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+            if (m_quit) return;
+            seen = m_generation;
+        }
+
+        // claim chunks until the request is exhausted
+        for (;;)
+        {
+            size_t begin = m_next.fetch_add(CHUNK_SIZE);
+            if (begin >= m_count) break;
+            size_t end = min(begin + CHUNK_SIZE, m_count);
+            for (size_t i = begin; i < end; ++i)
+                m_glyphs[i] = extractor.ExtractGlyph(m_characters[i]);
+        }
+
+        {
+            lock_guard<mutex> lock(m_lock);
+            if (--m_busy == 0) m_finished.notify_one();
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+
+bool GlyphExtractorPool::LoadFontFile(const string &filename)
+{
+    // workers are idle between requests, so their extractors can be used
+    // from this thread
+    bool loaded = true;
+    for (size_t i = 0; i < m_extractors.size(); ++i)
+        loaded = m_extractors[i]->LoadFontFile(filename) && loaded;
+    return loaded;
+}
+
+void GlyphExtractorPool::ExtractGlyphs(const int *characters, size_t count,
+                                       vector<MyGlyph> &glyphs)
+{
+    glyphs.resize(count);
+    if (count == 0) return;
+
+    unique_lock<mutex> lock(m_lock);
+    m_characters = characters;
+    m_count = count;
+    m_glyphs = &glyphs[0];
+    m_next = 0;
+    m_busy = m_threads.size();
+    ++m_generation;
+    m_wake.notify_all();
+
+    m_finished.wait(lock, [&] { return m_busy == 0; });
+    m_characters = 0;
+    m_glyphs = 0;
+    m_count = 0;
+}
+
+void GlyphExtractorPool::ExtractString(const string &text, vector<MyGlyph> &glyphs)
+{
+    vector<int> characters(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+        characters[i] = static_cast<unsigned char>(text[i]);
+    ExtractGlyphs(characters.empty() ? 0 : &characters[0], characters.size(), glyphs);
+}
+
+void GlyphExtractorPool::ExtractCharset(vector<int> &characters, vector<MyGlyph> &glyphs)
+{
+    characters = m_extractors[0]->CharacterSet();
+    ExtractGlyphs(characters.empty() ? 0 : &characters[0], characters.size(), glyphs);
+}
+
+void GlyphExtractorPool::ClearCache()
+{
+    for (size_t i = 0; i < m_extractors.size(); ++i)
+        m_extractors[i]->ClearCache();
+}
+
+// --------------------------------------------------------------------------
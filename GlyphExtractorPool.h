@@ -0,0 +1,72 @@
+// ==========================================================================
+// Parallel Glyph Extraction
+//
+// A GlyphExtractor is not safe to share between threads: decoding a glyph
+// goes through its face's single glyph slot. A GlyphExtractorPool instead
+// runs a fixed set of worker threads, each owning a complete GlyphExtractor
+// (its own FT_Library and FT_Face) over the same shared font mapping, and
+// splits the characters of a request between them. Results are written back
+// in request order, so callers see the same output as a serial loop.
+// ==========================================================================
+#ifndef GLYPHEXTRACTORPOOL_H
+#define GLYPHEXTRACTORPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GlyphExtractor.h"
+
+class GlyphExtractorPool
+{
+    std::vector<std::unique_ptr<GlyphExtractor> >  m_extractors;
+    std::vector<std::thread>                        m_threads;
+
+    // the request being worked on: workers claim chunks of characters by
+    // advancing m_next until it passes m_count
+    const int              *m_characters;
+    size_t                  m_count;
+    MyGlyph                *m_glyphs;
+    std::atomic<size_t>     m_next;
+
+    std::mutex              m_lock;
+    std::condition_variable m_wake;         // signals a new request or shutdown
+    std::condition_variable m_finished;     // signals the last worker is done
+    unsigned long           m_generation;   // incremented for every request
+    unsigned int            m_busy;         // workers still on this request
+    bool                    m_quit;
+
+    void WorkerLoop(unsigned int worker);
+
+    GlyphExtractorPool(const GlyphExtractorPool &) = delete;
+    GlyphExtractorPool &operator=(const GlyphExtractorPool &) = delete;
+
+public:
+    // starts [threads] workers, or one per hardware thread if zero
+    explicit GlyphExtractorPool(unsigned int threads = 0);
+    ~GlyphExtractorPool();
+
+    unsigned int ThreadCount() const    { return m_threads.size(); }
+
+    // loads the font into every worker; all workers share one file mapping
+    bool LoadFontFile(const std::string &filename);
+
+    // decodes the given characters concurrently; glyphs[i] receives the
+    // outline of characters[i]
+    void ExtractGlyphs(const int *characters, size_t count, std::vector<MyGlyph> &glyphs);
+    void ExtractString(const std::string &text, std::vector<MyGlyph> &glyphs);
+
+    // decodes every character the font maps, returning the character codes
+    // in ascending order alongside their glyphs
+    void ExtractCharset(std::vector<int> &characters, std::vector<MyGlyph> &glyphs);
+
+    // drops the outlines cached by every worker
+    void ClearCache();
+};
+
+// --------------------------------------------------------------------------
+#endif // GLYPHEXTRACTORPOOL_H
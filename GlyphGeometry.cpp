@@ -0,0 +1,257 @@
+// ==========================================================================
+// Patch Geometry Builder for Glyph Runs
+//
+// See GlyphGeometry.h for the patch layout.
+// ==========================================================================
+
+#include "GlyphGeometry.h"
+#include <algorithm>
+#include <cstring>
+
+#include "GlyphMesh.h"
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+void PatchArena::Grow(size_t capacity)
+{
+    // at least double, so a build of n floats reallocates O(log n) times
+    size_t grown = m_storage.size() * 2;
+    m_storage.resize(grown > capacity ? grown : capacity);
+}
+
+// --------------------------------------------------------------------------
+
+void GlyphGeometry::Clear()
+{
+    m_lines.Clear();
+    m_quadratics.Clear();
+    m_cubics.Clear();
+}
+
+void GlyphGeometry::AppendGlyph(const MyGlyphView &glyph, float scale,
+                                float xTrans, float yTrans)
+{
+    if (!glyph.Valid()) return;
+
+    const unsigned char *degrees = glyph.SegmentDegrees();
+    const unsigned int *first = glyph.SegmentPoints();
+    const float *points = glyph.Points();
+
+    // padding vertex for the unused slot of quadratic patches
+    float padX = xTrans * scale, padY = yTrans * scale;
+
+    for (unsigned int seg = 0; seg < glyph.SegmentCount(); ++seg)
+    {
+        int degree = degrees[seg];
+        if (degree < 1 || degree > 3) continue;
+
+        PatchArena &arena = degree == 1 ? m_lines : degree == 2 ? m_quadratics : m_cubics;
+        int vertices = degree == 1 ? LINE_VERTICES : PATCH_VERTICES;
+        float *patch = arena.Append(2 * vertices);
+
+        const float *p = points + 2 * first[seg];
+        int v = 0;
+        for (; v <= degree; ++v) {
+            patch[2*v]     = (p[2*v]     + xTrans) * scale;
+            patch[2*v + 1] = (p[2*v + 1] + yTrans) * scale;
+        }
+        for (; v < vertices; ++v) {
+            patch[2*v]     = padX;
+            patch[2*v + 1] = padY;
+        }
+    }
+}
+
+void GlyphGeometry::AppendRun(const MyGlyphRun &run, float scale, float xTrans, float yTrans)
+{
+    for (size_t i = 0; i < run.Size(); ++i)
+        AppendGlyph(run.Outline(i), scale, xTrans + run.glyphs[i].offset, yTrans);
+}
+
+size_t GlyphGeometry::CapacityBytes() const
+{
+    return (m_lines.Capacity() + m_quadratics.Capacity() + m_cubics.Capacity()) * sizeof(float);
+}
+
+// --------------------------------------------------------------------------
+
+void InstancedGlyphGeometry::Clear()
+{
+    m_patches.Clear();
+    for (int s = TRIANGLES; s < STREAM_COUNT; ++s)
+        m_fill[s - TRIANGLES].Clear();
+    m_outlines.clear();
+    m_blocks.clear();
+    m_byCharacter.clear();
+    m_pending.clear();
+    m_instances.clear();
+    for (int s = 0; s < STREAM_COUNT; ++s)
+        m_draws[s].clear();
+    m_finished = true;
+}
+
+unsigned int InstancedGlyphGeometry::AddOutline(const MyGlyphView &glyph, int character)
+{
+    size_t bytes = glyph.Valid() ? glyph.Size() : 0;
+
+    // reuse an identical outline of the same character from an earlier run
+    typedef unordered_multimap<int, unsigned int>::const_iterator Iterator;
+    pair<Iterator, Iterator> range = m_byCharacter.equal_range(character);
+    for (Iterator it = range.first; it != range.second; ++it)
+    {
+        const Outline &outline = m_outlines[it->second];
+        if (outline.bytes == bytes
+            && (bytes == 0 || memcmp(&m_blocks[outline.block], glyph.Data(), bytes) == 0))
+            return it->second;
+    }
+
+    Outline outline;
+    outline.character = character;
+    outline.block = m_blocks.size();
+    outline.bytes = bytes;
+    outline.instances = 0;
+    if (bytes) m_blocks.insert(m_blocks.end(), glyph.Data(), glyph.Data() + bytes);
+
+    size_t before[CUBICS + 1] = { m_patches.LineVertices(), m_patches.QuadraticVertices(),
+                                  m_patches.CubicVertices() };
+    m_patches.AppendGlyph(glyph, 1.f, 0.f, 0.f);
+    size_t after[CUBICS + 1] = { m_patches.LineVertices(), m_patches.QuadraticVertices(),
+                                 m_patches.CubicVertices() };
+    for (int s = 0; s <= CUBICS; ++s) {
+        outline.first[s] = before[s];
+        outline.count[s] = after[s] - before[s];
+    }
+    AppendFill(outline, glyph);
+
+    m_outlines.push_back(outline);
+    m_byCharacter.insert(make_pair(character, unsigned(m_outlines.size() - 1)));
+    return m_outlines.size() - 1;
+}
+
+// appends [vertices] to the fill stream [stream] of an outline
+void InstancedGlyphGeometry::AppendFill(Outline &outline, Stream stream,
+                                        const vector<float> &vertices)
+{
+    PatchArena &arena = m_fill[stream - TRIANGLES];
+    outline.first[stream] = arena.Size() / VertexFloats(stream);
+    outline.count[stream] = vertices.size() / VertexFloats(stream);
+    if (!vertices.empty())
+        copy(vertices.begin(), vertices.end(), arena.Append(vertices.size()));
+}
+
+void InstancedGlyphGeometry::AppendFill(Outline &outline, const MyGlyphView &glyph)
+{
+    static const vector<float> none;
+    AppendFill(outline, TRIANGLES,
+               m_meshCache ? m_meshCache->Mesh(glyph, m_meshTolerance).vertices : none);
+
+    if (m_curveFill)
+        CurveFill::Build(glyph, m_curveMesh);
+    else
+        m_curveMesh.Clear();
+    AppendFill(outline, CURVE_SOLIDS, m_curveMesh.solids);
+    AppendFill(outline, CURVE_QUADRATICS, m_curveMesh.quadratics);
+    AppendFill(outline, CURVE_CUBICS, m_curveMesh.cubics);
+}
+
+void InstancedGlyphGeometry::RebuildFill()
+{
+    for (int s = TRIANGLES; s < STREAM_COUNT; ++s)
+        m_fill[s - TRIANGLES].Clear();
+    for (size_t o = 0; o < m_outlines.size(); ++o)
+    {
+        Outline &outline = m_outlines[o];
+        AppendFill(outline, MyGlyphView(outline.bytes ? &m_blocks[outline.block] : 0));
+    }
+    m_finished = false;
+}
+
+void InstancedGlyphGeometry::AppendRun(const MyGlyphRun &run, float scale,
+                                       float xTrans, float yTrans)
+{
+    m_runOutlines.clear();
+    for (size_t i = 0; i < run.Size(); ++i)
+    {
+        const MyRunGlyph &entry = run.glyphs[i];
+        unordered_map<unsigned int, unsigned int>::const_iterator it =
+            m_runOutlines.find(entry.outline);
+        unsigned int outline;
+        if (it != m_runOutlines.end())
+            outline = it->second;
+        else {
+            outline = AddOutline(run.Outline(i), entry.character);
+            m_runOutlines[entry.outline] = outline;
+        }
+
+        GlyphInstance instance = { xTrans + entry.offset, yTrans, scale };
+        m_pending.push_back(make_pair(outline, instance));
+        ++m_outlines[outline].instances;
+    }
+    m_finished = false;
+}
+
+void InstancedGlyphGeometry::Finish()
+{
+    if (m_finished) return;
+
+    // counting sort of the instances by outline
+    unsigned int total = 0;
+    for (size_t o = 0; o < m_outlines.size(); ++o) {
+        m_outlines[o].firstInstance = total;
+        total += m_outlines[o].instances;
+    }
+
+    m_instances.resize(m_pending.size());
+    for (size_t o = 0; o < m_outlines.size(); ++o)
+        m_outlines[o].instances = 0;
+    for (size_t i = 0; i < m_pending.size(); ++i) {
+        Outline &outline = m_outlines[m_pending[i].first];
+        m_instances[outline.firstInstance + outline.instances++] = m_pending[i].second;
+    }
+
+    for (int s = 0; s < STREAM_COUNT; ++s)
+    {
+        m_draws[s].clear();
+        for (size_t o = 0; o < m_outlines.size(); ++o)
+        {
+            const Outline &outline = m_outlines[o];
+            if (outline.count[s] == 0 || outline.instances == 0) continue;
+            GlyphDraw draw = { outline.first[s], outline.count[s],
+                               outline.firstInstance, outline.instances };
+            m_draws[s].push_back(draw);
+        }
+    }
+    m_finished = true;
+}
+
+const float *InstancedGlyphGeometry::Patches(Stream stream) const
+{
+    return stream == LINES ? m_patches.Lines()
+         : stream == QUADRATICS ? m_patches.Quadratics()
+         : stream == CUBICS ? m_patches.Cubics()
+         : m_fill[stream - TRIANGLES].Data();
+}
+
+size_t InstancedGlyphGeometry::Vertices(Stream stream) const
+{
+    return stream == LINES ? m_patches.LineVertices()
+         : stream == QUADRATICS ? m_patches.QuadraticVertices()
+         : stream == CUBICS ? m_patches.CubicVertices()
+         : m_fill[stream - TRIANGLES].Size() / VertexFloats(stream);
+}
+
+const GlyphInstance *InstancedGlyphGeometry::Instances()
+{
+    Finish();
+    return m_instances.empty() ? 0 : &m_instances[0];
+}
+
+const vector<GlyphDraw> &InstancedGlyphGeometry::Draws(Stream stream)
+{
+    Finish();
+    return m_draws[stream];
+}
+
+// --------------------------------------------------------------------------
@@ -0,0 +1,210 @@
+// ==========================================================================
+// Patch Geometry Builder for Glyph Runs
+//
+// Turns glyph outlines into the geometry the shaders draw, one primitive per
+// segment, sorted by degree into line, quadratic and cubic streams. Straight
+// segments are plain 2-vertex GL_LINES pairs that bypass tessellation;
+// curves are 4-vertex patches for the tessellation shaders, with the unused
+// last vertex of quadratic patches padded with the transformed origin. Each
+// vertex is written as (x + xTrans) * scale.
+//
+// Patches are appended in a single pass over the outlines into arenas that
+// grow geometrically and are only rewound by Clear(), so a builder that is
+// kept between scenes stops allocating once it has seen its largest scene.
+//
+// InstancedGlyphGeometry instead stores every distinct outline once, in EM
+// units, and places each character with a (xTrans, yTrans, scale) instance
+// that the vertex shader applies, so vertex data grows with the number of
+// distinct glyphs rather than with the length of the text. Given a
+// GlyphMeshCache, it also keeps each outline's filled triangle mesh in a
+// fourth stream, and with curve fill enabled its resolution-independent
+// fill mesh (see CurveFill.h) in three more, one per kind of triangle, so
+// filled text is drawn the same way.
+// ==========================================================================
+#ifndef GLYPHGEOMETRY_H
+#define GLYPHGEOMETRY_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "CurveFill.h"
+#include "GlyphExtractor.h"
+
+class GlyphMeshCache;
+
+// a growable float buffer whose storage is kept when it is cleared
+class PatchArena
+{
+    std::vector<float>  m_storage;      // size() is the arena's capacity
+    size_t              m_used;
+
+public:
+    PatchArena() : m_used(0)
+    {}
+
+    // returns space for [count] more floats, growing the storage if needed
+    float *Append(size_t count)
+    {
+        if (m_used + count > m_storage.size())
+            Grow(m_used + count);
+        float *space = &m_storage[m_used];
+        m_used += count;
+        return space;
+    }
+
+    void Grow(size_t capacity);
+    void Clear()                        { m_used = 0; }
+
+    const float *Data() const           { return m_storage.empty() ? 0 : &m_storage[0]; }
+    size_t Size() const                 { return m_used; }
+    size_t Capacity() const             { return m_storage.size(); }
+};
+
+class GlyphGeometry
+{
+    PatchArena  m_lines;
+    PatchArena  m_quadratics;
+    PatchArena  m_cubics;
+
+public:
+    // number of vertices in every line and every curve patch
+    static const int LINE_VERTICES = 2;
+    static const int PATCH_VERTICES = 4;
+
+    // rewinds all streams, keeping their storage for the next build
+    void Clear();
+
+    // appends the patches of one glyph, or of every glyph of a run placed
+    // at its offset along the baseline
+    void AppendGlyph(const MyGlyphView &glyph, float scale, float xTrans, float yTrans);
+    void AppendRun(const MyGlyphRun &run, float scale, float xTrans, float yTrans);
+
+    // vertex data of each stream (x, y pairs) and its number of vertices
+    const float *Lines() const          { return m_lines.Data(); }
+    const float *Quadratics() const     { return m_quadratics.Data(); }
+    const float *Cubics() const         { return m_cubics.Data(); }
+    size_t LineVertices() const         { return m_lines.Size() / 2; }
+    size_t QuadraticVertices() const    { return m_quadratics.Size() / 2; }
+    size_t CubicVertices() const        { return m_cubics.Size() / 2; }
+
+    // bytes reserved by the arenas, for reporting
+    size_t CapacityBytes() const;
+};
+
+// --------------------------------------------------------------------------
+// Instanced glyph geometry
+
+// placement of one character: its vertices are drawn at (p + xy) * scale
+struct GlyphInstance
+{
+    float   xTrans;
+    float   yTrans;
+    float   scale;
+};
+
+// one instanced draw: a distinct glyph's patches in one stream, repeated
+// for a contiguous range of instances
+struct GlyphDraw
+{
+    unsigned int    firstVertex;
+    unsigned int    vertexCount;
+    unsigned int    firstInstance;
+    unsigned int    instanceCount;
+};
+
+class InstancedGlyphGeometry
+{
+public:
+    enum Stream { LINES, QUADRATICS, CUBICS, TRIANGLES, CURVE_SOLIDS, CURVE_QUADRATICS,
+                  CURVE_CUBICS, STREAM_COUNT };
+
+private:
+    // the distinct outlines, untransformed, and each one's vertex range
+    // per stream
+    struct Outline
+    {
+        int             character;
+        size_t          block;      // offset of its packed bytes in m_blocks
+        size_t          bytes;
+        unsigned int    first[STREAM_COUNT];
+        unsigned int    count[STREAM_COUNT];
+        unsigned int    instances;
+        unsigned int    firstInstance;  // set by Finish()
+    };
+    GlyphGeometry                   m_patches;
+    PatchArena                      m_fill[STREAM_COUNT - TRIANGLES];
+    std::vector<Outline>            m_outlines;
+    std::vector<unsigned char>      m_blocks;
+
+    // distinct outlines by character code, to share them between runs
+    std::unordered_multimap<int, unsigned int> m_byCharacter;
+    // outline index of each block of the run being appended
+    std::unordered_map<unsigned int, unsigned int> m_runOutlines;
+
+    // instances in append order with their outline, then grouped by outline
+    std::vector<std::pair<unsigned int, GlyphInstance> > m_pending;
+    std::vector<GlyphInstance>      m_instances;
+    std::vector<GlyphDraw>          m_draws[STREAM_COUNT];
+    bool                            m_finished;
+
+    // source of the filled meshes, if any, and their tolerance in EM units
+    GlyphMeshCache                 *m_meshCache;
+    float                           m_meshTolerance;
+
+    // whether to build curve fill meshes, and the one being built
+    bool                            m_curveFill;
+    CurveMesh                       m_curveMesh;
+
+    unsigned int AddOutline(const MyGlyphView &glyph, int character);
+    void AppendFill(Outline &outline, Stream stream, const std::vector<float> &vertices);
+    void AppendFill(Outline &outline, const MyGlyphView &glyph);
+
+public:
+    InstancedGlyphGeometry()
+        : m_finished(true), m_meshCache(0), m_meshTolerance(0.f), m_curveFill(false)
+    {}
+
+    // fills the TRIANGLES stream of outlines added from now on with their
+    // meshes from [cache], flattened within [tolerance] EM units; a null
+    // cache leaves it empty
+    void SetMeshCache(GlyphMeshCache *cache, float tolerance)
+    { m_meshCache = cache; m_meshTolerance = tolerance; }
+
+    // fills the CURVE_ streams of outlines added from now on, or leaves
+    // them empty (the default)
+    void SetCurveFill(bool enable)      { m_curveFill = enable; }
+
+    // rebuilds the TRIANGLES and CURVE_ streams of every outline with the
+    // current mesh cache and curve fill settings, so that a change of fill
+    // mode does not need the text to be laid out again
+    void RebuildFill();
+
+    // rewinds the geometry, keeping its storage for the next build
+    void Clear();
+
+    // adds one instance per glyph of a run, placed as GlyphGeometry does;
+    // outlines already added, from this run or an earlier one, are reused
+    void AppendRun(const MyGlyphRun &run, float scale, float xTrans, float yTrans);
+
+    // groups the instances by outline and builds the draw lists; called
+    // automatically by the accessors below
+    void Finish();
+
+    // untransformed patch data of a stream and its number of vertices; the
+    // TRIANGLES and CURVE_ streams are plain triangle lists, and only
+    // CURVE_CUBICS has implicit curve coordinates after each position
+    const float *Patches(Stream stream) const;
+    size_t Vertices(Stream stream) const;
+    static int VertexFloats(Stream stream)
+    { return stream == CURVE_CUBICS ? CurveFill::VERTEX_FLOATS : 2; }
+
+    // instances grouped by outline, and the draws that cover them
+    const GlyphInstance *Instances();
+    size_t InstanceCount() const        { return m_pending.size(); }
+    const std::vector<GlyphDraw> &Draws(Stream stream);
+
+    size_t OutlineCount() const         { return m_outlines.size(); }
+};
+
+// --------------------------------------------------------------------------
+#endif // GLYPHGEOMETRY_H
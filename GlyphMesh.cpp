@@ -0,0 +1,240 @@
+// ==========================================================================
+// Filled Glyph Meshes
+//
+// See GlyphMesh.h. Heights closer together than EPSILON are not split, so
+// crossings that nearly coincide with a vertex height are absorbed into
+// the slab with an error below that distance.
+// ==========================================================================
+
+#include "GlyphMesh.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+static const float EPSILON = 1e-6f;
+
+// --------------------------------------------------------------------------
+
+void Triangulator::SortActive(float y)
+{
+    const vector<Edge> &edges = m_edges;
+    sort(m_active.begin(), m_active.end(), [&](unsigned int a, unsigned int b) {
+        float xa = edges[a].X(y), xb = edges[b].X(y);
+        return xa < xb || (xa == xb && edges[a].dxdy < edges[b].dxdy);
+    });
+}
+
+void Triangulator::CloseSpan(const Span &span, float top, vector<float> &triangles) const
+{
+    const Edge &left = m_edges[span.left], &right = m_edges[span.right];
+    float bottom = span.bottom;
+    float x[4] = { left.X(bottom), right.X(bottom), right.X(top), left.X(top) };
+    float y[4] = { bottom, bottom, top, top };
+
+    // the trapezoid as the fan (0 1 2), (0 2 3), leaving out slivers
+    for (int t = 1; t <= 2; ++t)
+    {
+        float area = (x[t] - x[0]) * (y[t + 1] - y[0]) - (x[t + 1] - x[0]) * (y[t] - y[0]);
+        if (fabs(area) < EPSILON * EPSILON) continue;
+        int corners[3] = { 0, t, t + 1 };
+        for (int c = 0; c < 3; ++c) {
+            triangles.push_back(x[corners[c]]);
+            triangles.push_back(y[corners[c]]);
+        }
+    }
+}
+
+void Triangulator::Triangulate(const Polylines &contours, vector<float> &triangles)
+{
+    triangles.clear();
+    m_edges.clear();
+    m_heights.clear();
+    m_active.clear();
+    m_open.clear();
+
+    // non-horizontal edges, pointing up, with the direction they had
+    for (size_t c = 0; c < contours.Count(); ++c)
+        for (unsigned int p = contours.starts[c]; p + 1 < contours.starts[c + 1]; ++p)
+        {
+            const float *a = &contours.points[2 * p], *b = a + 2;
+            if (a[1] == b[1]) continue;
+            Edge edge;
+            edge.winding = a[1] < b[1] ? 1 : -1;
+            if (edge.winding < 0) swap(a, b);
+            edge.x0 = a[0];
+            edge.y0 = a[1];
+            edge.x1 = b[0];
+            edge.y1 = b[1];
+            edge.dxdy = (edge.x1 - edge.x0) / (edge.y1 - edge.y0);
+            m_edges.push_back(edge);
+            m_heights.push_back(edge.y0);
+            m_heights.push_back(edge.y1);
+        }
+    if (m_edges.empty()) return;
+
+    sort(m_edges.begin(), m_edges.end(), [](const Edge &a, const Edge &b) { return a.y0 < b.y0; });
+    sort(m_heights.begin(), m_heights.end());
+    m_heights.erase(unique(m_heights.begin(), m_heights.end()), m_heights.end());
+
+    size_t next = 0;
+    for (size_t h = 0; h + 1 < m_heights.size(); ++h)
+    {
+        float ya = m_heights[h], top = m_heights[h + 1];
+
+        // edges that end here leave the sweep, edges that start here join it
+        size_t kept = 0;
+        for (size_t i = 0; i < m_active.size(); ++i)
+            if (m_edges[m_active[i]].y1 > ya) m_active[kept++] = m_active[i];
+        m_active.resize(kept);
+        for (; next < m_edges.size() && m_edges[next].y0 <= ya; ++next)
+            if (m_edges[next].y1 > ya) m_active.push_back(next);
+
+        while (ya < top)
+        {
+            // shrink the slab to its lowest crossing until none is left
+            float yb = top;
+            for (;;)
+            {
+                SortActive(0.5f * (ya + yb));
+                float crossing = yb;
+                for (size_t i = 0; i + 1 < m_active.size(); ++i)
+                {
+                    const Edge &e = m_edges[m_active[i]], &f = m_edges[m_active[i + 1]];
+                    float da = e.X(ya) - f.X(ya), db = e.X(yb) - f.X(yb);
+                    if ((da > EPSILON || db > EPSILON) && da != db) {
+                        float y = ya + (yb - ya) * da / (da - db);
+                        if (y > ya + EPSILON && y < crossing - EPSILON) crossing = y;
+                    }
+                }
+                if (crossing == yb) break;
+                yb = crossing;
+            }
+
+            // filled spans of the slab, continuing the open ones where the
+            // same two edges bound them
+            m_next.clear();
+            int winding = 0;
+            unsigned int left = 0;
+            for (size_t i = 0; i < m_active.size(); ++i)
+            {
+                unsigned int e = m_active[i];
+                int before = winding;
+                winding += m_edges[e].winding;
+                if (before == 0 && winding != 0)
+                    left = e;
+                else if (before != 0 && winding == 0)
+                {
+                    Span span = { left, e, ya };
+                    for (size_t o = 0; o < m_open.size(); ++o)
+                        if (m_open[o].left == left && m_open[o].right == e) {
+                            span.bottom = m_open[o].bottom;
+                            m_open[o].left = UINT_MAX;
+                            break;
+                        }
+                    m_next.push_back(span);
+                }
+            }
+            for (size_t o = 0; o < m_open.size(); ++o)
+                if (m_open[o].left != UINT_MAX) CloseSpan(m_open[o], ya, triangles);
+            m_open.swap(m_next);
+            ya = yb;
+        }
+    }
+
+    for (size_t o = 0; o < m_open.size(); ++o)
+        CloseSpan(m_open[o], m_heights.back(), triangles);
+    m_open.clear();
+}
+
+void Triangulator::Triangulate(const MyGlyphView &glyph, float tolerance, vector<float> &triangles)
+{
+    Flattener::Flatten(glyph, tolerance, m_polylines);
+    Triangulate(m_polylines, triangles);
+}
+
+void Triangulator::Triangulate(const MyGlyph &glyph, float tolerance, vector<float> &triangles)
+{
+    Flattener::Flatten(glyph, tolerance, m_polylines);
+    Triangulate(m_polylines, triangles);
+}
+
+// --------------------------------------------------------------------------
+
+GlyphMeshCache::GlyphMeshCache(size_t budgetBytes)
+    : m_budget(budgetBytes), m_bytes(0), m_hits(0), m_misses(0), m_evictions(0)
+{
+}
+
+const GlyphMesh &GlyphMeshCache::Mesh(const MyGlyphView &glyph, float tolerance)
+{
+    Key key = { 14695981039346656037ULL, glyph.Valid() ? glyph.Size() : 0,
+                PolylineCache::Bucket(tolerance) };
+    const unsigned char *data = key.bytes ? glyph.Data() : 0;
+    for (size_t i = 0; i < key.bytes; ++i)
+        key.hash = (key.hash ^ data[i]) * 1099511628211ULL;
+
+    // a hash match is only a hit if the outline itself matches
+    typedef unordered_multimap<Key, EntryList::iterator, KeyHash>::iterator IndexIterator;
+    pair<IndexIterator, IndexIterator> range = m_index.equal_range(key);
+    for (IndexIterator found = range.first; found != range.second; ++found)
+    {
+        const vector<unsigned char> &outline = found->second->outline;
+        if (key.bytes && memcmp(&outline[0], data, key.bytes)) continue;
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return found->second->mesh;
+    }
+
+    ++m_misses;
+    m_entries.push_front(Entry());
+    Entry &entry = m_entries.front();
+    entry.key = key;
+    entry.outline.assign(data, data + key.bytes);
+    if (glyph.Valid())
+        m_triangulator.Triangulate(glyph, PolylineCache::BucketTolerance(key.bucket),
+                                   entry.mesh.vertices);
+    entry.mesh.vertices.shrink_to_fit();
+    entry.bytes = entry.mesh.vertices.capacity() * sizeof(float) + entry.outline.capacity() +
+                  sizeof(Entry) + sizeof(void *) * 4 + sizeof(Key);
+
+    m_index.insert(make_pair(key, m_entries.begin()));
+    m_bytes += entry.bytes;
+    Trim();
+    return entry.mesh;
+}
+
+void GlyphMeshCache::Trim()
+{
+    while (m_bytes > m_budget && m_entries.size() > 1)
+    {
+        EntryList::iterator victim = --m_entries.end();
+        typedef unordered_multimap<Key, EntryList::iterator, KeyHash>::iterator IndexIterator;
+        pair<IndexIterator, IndexIterator> range = m_index.equal_range(victim->key);
+        for (IndexIterator found = range.first; found != range.second; ++found)
+            if (found->second == victim) {
+                m_index.erase(found);
+                break;
+            }
+        m_bytes -= victim->bytes;
+        m_entries.erase(victim);
+        ++m_evictions;
+    }
+}
+
+void GlyphMeshCache::SetBudget(size_t budgetBytes)
+{
+    m_budget = budgetBytes;
+    Trim();
+}
+
+void GlyphMeshCache::Clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+// --------------------------------------------------------------------------
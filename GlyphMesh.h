@@ -0,0 +1,146 @@
+// ==========================================================================
+// Filled Glyph Meshes
+//
+// A Triangulator turns a glyph's flattened contours into a triangle list
+// covering the area the nonzero fill rule paints, so counters such as those
+// of 'o' and 'B' stay open whichever way their contours wind. It sweeps the
+// outline from bottom to top in slabs between consecutive vertex heights,
+// splitting a slab further wherever two edges cross inside it, so that
+// within each slab the edges are ordered left to right. Walking that order
+// with a running winding number gives the filled spans; a span bounded by
+// the same pair of edges as the span below it extends that trapezoid, and
+// every finished trapezoid becomes two triangles.
+//
+// A GlyphMeshCache keeps the meshes of recently used outlines, in EM units,
+// keyed by the outline's packed bytes and a tolerance bucket (see
+// PolylineCache), so a string is filled with instanced draws of meshes
+// that are triangulated once per distinct glyph. Like PolylineCache it
+// holds a memory budget, evicting the least recently used meshes beyond it.
+// ==========================================================================
+#ifndef GLYPHMESH_H
+#define GLYPHMESH_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "PolylineCache.h"
+
+// a triangle list, three (x, y) vertices per triangle
+struct GlyphMesh
+{
+    std::vector<float>  vertices;
+
+    size_t VertexCount() const          { return vertices.size() / 2; }
+    size_t TriangleCount() const        { return vertices.size() / 6; }
+};
+
+class Triangulator
+{
+    struct Edge
+    {
+        float   x0, y0;     // lower end point
+        float   x1, y1;     // upper end point
+        float   dxdy;
+        int     winding;    // +1 upwards, -1 downwards
+
+        float X(float y) const          { return x0 + (y - y0) * dxdy; }
+    };
+
+    // a filled span between two edges, open since height [bottom]
+    struct Span
+    {
+        unsigned int    left;
+        unsigned int    right;
+        float           bottom;
+    };
+
+    // scratch kept between calls, so triangulation stops allocating once
+    // it has seen its largest glyph
+    Polylines                   m_polylines;
+    std::vector<Edge>           m_edges;
+    std::vector<float>          m_heights;
+    std::vector<unsigned int>   m_active;
+    std::vector<Span>           m_open;
+    std::vector<Span>           m_next;
+
+    // orders the active edges by their x at height y
+    void SortActive(float y);
+    void CloseSpan(const Span &span, float top, std::vector<float> &triangles) const;
+
+public:
+    // triangulates closed contours (as Flattener writes them), replacing
+    // the contents of [triangles]
+    void Triangulate(const Polylines &contours, std::vector<float> &triangles);
+
+    // flattens a glyph within [tolerance] and triangulates it
+    void Triangulate(const MyGlyphView &glyph, float tolerance, std::vector<float> &triangles);
+    void Triangulate(const MyGlyph &glyph, float tolerance, std::vector<float> &triangles);
+};
+
+class GlyphMeshCache
+{
+    struct Key
+    {
+        unsigned long long  hash;       // FNV-1a of the packed outline
+        size_t              bytes;
+        int                 bucket;
+
+        bool operator==(const Key &other) const
+        { return hash == other.hash && bytes == other.bytes && bucket == other.bucket; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        { return size_t(key.hash ^ (key.hash >> 32) ^ ((unsigned long long)key.bucket << 20)); }
+    };
+
+    struct Entry
+    {
+        Key                         key;
+        std::vector<unsigned char>  outline;    // the packed outline, to tell collisions apart
+        GlyphMesh                   mesh;
+        size_t                      bytes;
+    };
+
+    // most recently used first; the map points into the list, and holds
+    // every entry of a key, since different outlines may share a hash
+    typedef std::list<Entry> EntryList;
+    EntryList                                                   m_entries;
+    std::unordered_multimap<Key, EntryList::iterator, KeyHash>  m_index;
+
+    Triangulator    m_triangulator;
+    size_t          m_budget;
+    size_t          m_bytes;
+    unsigned long   m_hits;
+    unsigned long   m_misses;
+    unsigned long   m_evictions;
+
+    // drops least recently used entries, other than the newest, until the
+    // total fits the budget
+    void Trim();
+
+public:
+    explicit GlyphMeshCache(size_t budgetBytes = 8 << 20);
+
+    // the mesh of an outline, flattened within [tolerance] EM units; the
+    // reference is valid until the next call that may insert or evict
+    const GlyphMesh &Mesh(const MyGlyphView &glyph, float tolerance);
+
+    // changes the memory budget, evicting entries if it shrank
+    void SetBudget(size_t budgetBytes);
+    size_t Budget() const               { return m_budget; }
+
+    void Clear();
+
+    // statistics
+    size_t Size() const                 { return m_entries.size(); }
+    size_t Bytes() const                { return m_bytes; }
+    unsigned long Hits() const          { return m_hits; }
+    unsigned long Misses() const        { return m_misses; }
+    unsigned long Evictions() const     { return m_evictions; }
+};
+
+// --------------------------------------------------------------------------
+#endif // GLYPHMESH_H
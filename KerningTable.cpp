@@ -0,0 +1,391 @@
+// ==========================================================================
+// Per-face Kerning Tables
+//
+// A KerningTable is built once when a face is first opened, from the font's
+// 'kern' table and the PairPos lookups of its GPOS 'kern' feature. See
+// KerningTable.h for how the pairs are stored.
+// ==========================================================================
+
+#include "KerningTable.h"
+#include <algorithm>
+
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+// Big-endian readers over a loaded sfnt table; reads past the end return
+// zero, so malformed tables produce empty results rather than crashes
+
+namespace {
+    struct TableReader
+    {
+        vector<unsigned char> bytes;
+
+        bool Load(FT_Face face, FT_ULong tag)
+        {
+            FT_ULong length = 0;
+            if (FT_Load_Sfnt_Table(face, tag, 0, 0, &length) || length == 0)
+                return false;
+            bytes.resize(length);
+            return FT_Load_Sfnt_Table(face, tag, 0, &bytes[0], &length) == 0;
+        }
+
+        bool Has(size_t offset, size_t count) const
+        { return offset + count <= bytes.size(); }
+
+        unsigned int U16(size_t offset) const
+        { return Has(offset, 2) ? (bytes[offset] << 8) | bytes[offset+1] : 0; }
+
+        int S16(size_t offset) const
+        { return static_cast<short>(U16(offset)); }
+
+        unsigned int U32(size_t offset) const
+        { return (U16(offset) << 16) | U16(offset + 2); }
+    };
+
+    unsigned int PairKey(unsigned int left, unsigned int right)
+    {
+        return (left << 16) | (right & 0xFFFF);
+    }
+
+    // size in bytes of a GPOS value record with the given format
+    size_t ValueRecordSize(unsigned int format)
+    {
+        size_t size = 0;
+        for (unsigned int bit = 1; bit <= 0x80; bit <<= 1)
+            if (format & bit) size += 2;
+        return size;
+    }
+
+    // horizontal advance adjustment held by a value record, if any
+    int ValueXAdvance(const TableReader &table, size_t offset, unsigned int format)
+    {
+        if (!(format & 0x4)) return 0;
+        // the X advance follows the X and Y placements, when present
+        if (format & 0x1) offset += 2;
+        if (format & 0x2) offset += 2;
+        return table.S16(offset);
+    }
+
+    // calls visit(glyph, coverage index) for every glyph in a coverage table
+    template <typename Visit>
+    void ReadCoverage(const TableReader &table, size_t offset, Visit visit)
+    {
+        unsigned int format = table.U16(offset);
+        unsigned int count = table.U16(offset + 2);
+        if (format == 1) {
+            for (unsigned int i = 0; i < count; ++i)
+                visit(table.U16(offset + 4 + 2*i), i);
+        }
+        else if (format == 2) {
+            for (unsigned int r = 0; r < count; ++r)
+            {
+                size_t record = offset + 4 + 6*r;
+                unsigned int start = table.U16(record), end = table.U16(record + 2);
+                unsigned int index = table.U16(record + 4);
+                for (unsigned int g = start; g <= end && g >= start; ++g)
+                    visit(g, index + (g - start));
+            }
+        }
+    }
+
+    // fills classes[glyph] from a class definition table (unlisted glyphs
+    // keep class 0)
+    void ReadClassDef(const TableReader &table, size_t offset, vector<unsigned short> &classes)
+    {
+        unsigned int format = table.U16(offset);
+        if (format == 1) {
+            unsigned int start = table.U16(offset + 2), count = table.U16(offset + 4);
+            for (unsigned int i = 0; i < count && start + i < classes.size(); ++i)
+                classes[start + i] = table.U16(offset + 6 + 2*i);
+        }
+        else if (format == 2) {
+            unsigned int count = table.U16(offset + 2);
+            for (unsigned int r = 0; r < count; ++r)
+            {
+                size_t record = offset + 4 + 6*r;
+                unsigned int start = table.U16(record), end = table.U16(record + 2);
+                unsigned int value = table.U16(record + 4);
+                for (unsigned int g = start; g <= end && g < classes.size(); ++g)
+                    classes[g] = value;
+            }
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+
+const unsigned short KerningTable::NOT_COVERED;
+
+bool KerningTable::Build(FT_Face face)
+{
+    m_lookups.clear();
+    m_pairCount = 0;
+    if (!face || !FT_IS_SFNT(face)) return false;
+
+    // fonts that carry both usually repeat the same pairs in each, so as in
+    // OpenType shapers the 'kern' table is only read without a GPOS 'kern'
+    float em = face->units_per_EM;
+    return LoadGPOS(face, em) || LoadKern(face, em);
+}
+
+bool KerningTable::LoadKern(FT_Face face, float em)
+{
+    TableReader table;
+    if (!table.Load(face, TTAG_kern)) return false;
+
+    // the Microsoft header is a 16-bit version 0, Apple's a 32-bit 1.0
+    bool apple = table.U32(0) == 0x00010000;
+    unsigned int tables = apple ? table.U32(4) : table.U16(2);
+    size_t offset = apple ? 8 : 4;
+
+    Subtable subtable;
+    for (unsigned int t = 0; t < tables && table.Has(offset, 8); ++t)
+    {
+        size_t length, header;
+        unsigned int format;
+        bool horizontal;
+        if (apple) {
+            length = table.U32(offset);
+            unsigned int coverage = table.U16(offset + 4);
+            format = coverage & 0xFF;
+            horizontal = (coverage & 0xE000) == 0;  // not vertical, cross-stream or variation
+            header = 8;
+        }
+        else {
+            length = table.U16(offset + 2);
+            unsigned int coverage = table.U16(offset + 4);
+            format = coverage >> 8;
+            horizontal = (coverage & 0x7) == 0x1;   // horizontal, not minimum or cross-stream
+            header = 6;
+        }
+
+        if (format == 0)
+        {
+            size_t body = offset + header;
+            unsigned int count = table.U16(body);
+            for (unsigned int i = 0; i < count && horizontal; ++i)
+            {
+                size_t pair = body + 8 + 6*i;
+                int value = table.S16(pair + 4);
+                if (value == 0) continue;
+                float &kern = subtable.pairs[PairKey(table.U16(pair), table.U16(pair + 2))];
+                kern += value / em;
+            }
+            // large subtables overflow the 16-bit length field, so step over
+            // format 0 subtables by their pair count instead
+            length = header + 8 + 6 * size_t(count);
+        }
+        if (length == 0) break;
+        offset += length;
+    }
+
+    if (subtable.pairs.empty()) return false;
+    m_pairCount += subtable.pairs.size();
+    m_lookups.push_back(PairLookup(1, subtable));
+    return true;
+}
+
+bool KerningTable::LoadGPOS(FT_Face face, float em)
+{
+    TableReader table;
+    if (!table.Load(face, TTAG_GPOS)) return false;
+
+    size_t featureList = table.U16(6), lookupList = table.U16(8);
+    size_t glyphCount = face->num_glyphs;
+
+    // gather the lookups of every 'kern' feature, in lookup order
+    vector<unsigned int> lookups;
+    unsigned int features = table.U16(featureList);
+    for (unsigned int f = 0; f < features; ++f)
+    {
+        size_t record = featureList + 2 + 6*f;
+        if (table.U32(record) != FT_MAKE_TAG('k', 'e', 'r', 'n')) continue;
+        size_t feature = featureList + table.U16(record + 4);
+        unsigned int count = table.U16(feature + 2);
+        for (unsigned int i = 0; i < count; ++i)
+            lookups.push_back(table.U16(feature + 4 + 2*i));
+    }
+    sort(lookups.begin(), lookups.end());
+    lookups.erase(unique(lookups.begin(), lookups.end()), lookups.end());
+
+    bool found = false;
+    for (size_t l = 0; l < lookups.size(); ++l)
+    {
+        if (lookups[l] >= table.U16(lookupList)) continue;
+        size_t lookup = lookupList + table.U16(lookupList + 2 + 2*lookups[l]);
+        unsigned int type = table.U16(lookup);
+        unsigned int subtables = table.U16(lookup + 4);
+
+        PairLookup pairLookup;
+        for (unsigned int s = 0; s < subtables; ++s)
+        {
+            size_t sub = lookup + table.U16(lookup + 6 + 2*s);
+
+            // extension subtables point at the real one with a 32-bit offset
+            unsigned int subType = type;
+            if (type == 9) {
+                subType = table.U16(sub + 2);
+                sub += table.U32(sub + 4);
+            }
+            if (subType != 2) continue;
+
+            unsigned int format = table.U16(sub);
+            size_t coverage = sub + table.U16(sub + 2);
+            unsigned int valueFormat1 = table.U16(sub + 4), valueFormat2 = table.U16(sub + 6);
+            size_t recordSize = ValueRecordSize(valueFormat1) + ValueRecordSize(valueFormat2);
+
+            if (format == 1)
+            {
+                // consecutive explicit-pair subtables share one hash table;
+                // the earlier subtable keeps precedence for a repeated pair
+                if (pairLookup.empty() || pairLookup.back().ClassBased())
+                    pairLookup.push_back(Subtable());
+                Subtable &target = pairLookup.back();
+                size_t before = target.pairs.size();
+
+                unsigned int pairSets = table.U16(sub + 8);
+                ReadCoverage(table, coverage, [&](unsigned int left, unsigned int index) {
+                    if (index >= pairSets) return;
+                    size_t set = sub + table.U16(sub + 10 + 2*index);
+                    unsigned int count = table.U16(set);
+                    for (unsigned int i = 0; i < count; ++i)
+                    {
+                        size_t record = set + 2 + i * (2 + recordSize);
+                        unsigned int key = PairKey(left, table.U16(record));
+                        if (target.pairs.count(key)) continue;
+                        target.pairs[key] = ValueXAdvance(table, record + 2, valueFormat1) / em;
+                    }
+                });
+                m_pairCount += target.pairs.size() - before;
+            }
+            else if (format == 2)
+            {
+                Subtable target;
+                target.class1.assign(glyphCount, NOT_COVERED);
+                target.class2.assign(glyphCount, 0);
+
+                vector<unsigned short> classes(glyphCount, 0);
+                ReadClassDef(table, sub + table.U16(sub + 8), classes);
+                ReadCoverage(table, coverage, [&](unsigned int glyph, unsigned int) {
+                    if (glyph < glyphCount) target.class1[glyph] = classes[glyph];
+                });
+                ReadClassDef(table, sub + table.U16(sub + 10), target.class2);
+
+                unsigned int class1Count = table.U16(sub + 12);
+                target.class2Count = table.U16(sub + 14);
+                target.values.resize(class1Count * target.class2Count);
+                for (unsigned int c1 = 0; c1 < class1Count; ++c1)
+                    for (unsigned int c2 = 0; c2 < target.class2Count; ++c2)
+                    {
+                        size_t record = sub + 16 + (c1 * target.class2Count + c2) * recordSize;
+                        target.values[c1 * target.class2Count + c2] =
+                            ValueXAdvance(table, record, valueFormat1) / em;
+                    }
+
+                // glyphs whose class is out of range are treated as uncovered
+                for (size_t g = 0; g < glyphCount; ++g)
+                    if (target.class1[g] >= class1Count) target.class1[g] = NOT_COVERED;
+                for (size_t g = 0; g < glyphCount; ++g)
+                    if (target.class2[g] >= target.class2Count) target.class2[g] = 0;
+
+                if (target.class2Count > 0) pairLookup.push_back(target);
+            }
+        }
+
+        if (!pairLookup.empty()) {
+            m_lookups.push_back(pairLookup);
+            found = true;
+        }
+    }
+    return found;
+}
+
+// --------------------------------------------------------------------------
+
+size_t KerningTable::ClassSubtableCount() const
+{
+    size_t count = 0;
+    for (size_t l = 0; l < m_lookups.size(); ++l)
+        for (size_t s = 0; s < m_lookups[l].size(); ++s)
+            if (m_lookups[l][s].ClassBased()) ++count;
+    return count;
+}
+
+float KerningTable::Lookup(unsigned int left, unsigned int right) const
+{
+    float kerning = 0.f;
+    for (size_t l = 0; l < m_lookups.size(); ++l)
+    {
+        const PairLookup &lookup = m_lookups[l];
+        for (size_t s = 0; s < lookup.size(); ++s)
+        {
+            const Subtable &subtable = lookup[s];
+            if (subtable.ClassBased())
+            {
+                if (left >= subtable.class1.size() || right >= subtable.class2.size()) continue;
+                unsigned int c1 = subtable.class1[left];
+                if (c1 == NOT_COVERED) continue;
+                kerning += subtable.values[c1 * subtable.class2Count + subtable.class2[right]];
+                break;
+            }
+
+            unordered_map<unsigned int, float>::const_iterator it =
+                subtable.pairs.find(PairKey(left, right));
+            if (it != subtable.pairs.end()) {
+                kerning += it->second;
+                break;
+            }
+        }
+    }
+    return kerning;
+}
+
+void KerningTable::Pairs(const vector<unsigned int> &glyphs,
+                         vector<pair<unsigned int, unsigned int> > &pairs) const
+{
+    unsigned int largest = 0;
+    for (size_t i = 0; i < glyphs.size(); ++i) largest = max(largest, glyphs[i]);
+    vector<bool> wanted(largest + 1, false);
+    for (size_t i = 0; i < glyphs.size(); ++i) wanted[glyphs[i]] = true;
+
+    for (size_t l = 0; l < m_lookups.size(); ++l)
+        for (size_t s = 0; s < m_lookups[l].size(); ++s)
+        {
+            const Subtable &subtable = m_lookups[l][s];
+            if (!subtable.ClassBased())
+            {
+                for (unordered_map<unsigned int, float>::const_iterator it = subtable.pairs.begin();
+                     it != subtable.pairs.end(); ++it)
+                {
+                    unsigned int left = it->first >> 16, right = it->first & 0xFFFF;
+                    if (it->second != 0.f && left <= largest && right <= largest
+                        && wanted[left] && wanted[right])
+                        pairs.push_back(make_pair(left, right));
+                }
+                continue;
+            }
+
+            // the wanted glyphs by second class, then each covered left
+            // glyph's nonzero row of the matrix
+            vector<vector<unsigned int> > byClass(subtable.class2Count);
+            for (size_t i = 0; i < glyphs.size(); ++i)
+                if (glyphs[i] < subtable.class2.size())
+                    byClass[subtable.class2[glyphs[i]]].push_back(glyphs[i]);
+
+            for (size_t i = 0; i < glyphs.size(); ++i)
+            {
+                unsigned int left = glyphs[i];
+                if (left >= subtable.class1.size() || subtable.class1[left] == NOT_COVERED) continue;
+                const float *row = &subtable.values[subtable.class1[left] * subtable.class2Count];
+                for (unsigned int c2 = 0; c2 < subtable.class2Count; ++c2)
+                    if (row[c2] != 0.f)
+                        for (size_t r = 0; r < byClass[c2].size(); ++r)
+                            pairs.push_back(make_pair(left, byClass[c2][r]));
+            }
+        }
+}
+
+// --------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+// ==========================================================================
+// Per-face Kerning Tables
+//
+// A KerningTable is built once when a face is first opened, from the font's
+// pair kerning data:
+//  - the PairPos lookups (formats 1 and 2) of the GPOS 'kern' feature, which
+//    is where CFF fonts such as Source Sans Pro keep their kerning, or else
+//  - 'kern' table format 0 subtables (what FT_Get_Kerning reads).
+// Explicit glyph pairs are stored in a hash table; class-based subtables are
+// kept as per-glyph class arrays and a class-pair value matrix, since
+// expanding them into pairs would cost megabytes. Values are in EM units.
+// ==========================================================================
+#ifndef KERNINGTABLE_H
+#define KERNINGTABLE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+class KerningTable
+{
+    // a run of pair adjustments applied in order, first match wins
+    struct Subtable
+    {
+        // explicit pairs, keyed by (left << 16 | right)
+        std::unordered_map<unsigned int, float> pairs;
+
+        // class-based pairs: class1 is NOT_COVERED for glyphs outside the
+        // subtable's coverage; values has class1Count * class2Count entries
+        std::vector<unsigned short> class1;
+        std::vector<unsigned short> class2;
+        unsigned int                class2Count;
+        std::vector<float>          values;
+
+        bool ClassBased() const     { return !class1.empty(); }
+    };
+
+    // each lookup contributes the value of its first matching subtable,
+    // and the contributions of all lookups add up
+    typedef std::vector<Subtable> PairLookup;
+    std::vector<PairLookup> m_lookups;
+
+    size_t m_pairCount;
+
+    bool LoadKern(FT_Face face, float em);
+    bool LoadGPOS(FT_Face face, float em);
+
+public:
+    static const unsigned short NOT_COVERED = 0xFFFF;
+
+    KerningTable() : m_pairCount(0)
+    {}
+
+    // reads the face's kerning data; returns false if it has none
+    bool Build(FT_Face face);
+
+    bool Empty() const              { return m_lookups.empty(); }
+
+    // number of explicit pairs and of class-based subtables, for reporting
+    size_t PairCount() const        { return m_pairCount; }
+    size_t ClassSubtableCount() const;
+
+    // horizontal adjustment between two glyph indices, in EM units
+    float Lookup(unsigned int left, unsigned int right) const;
+
+    // appends the pairs of [glyphs] that some subtable holds a nonzero
+    // entry for, explicit or by class, which includes every pair Lookup
+    // gives a nonzero value; a pair may be appended more than once. This
+    // walks the explicit pairs and one class row per covered glyph rather
+    // than every combination of glyphs
+    void Pairs(const std::vector<unsigned int> &glyphs,
+               std::vector<std::pair<unsigned int, unsigned int> > &pairs) const;
+};
+
+// --------------------------------------------------------------------------
+#endif // KERNINGTABLE_H
@@ -0,0 +1,115 @@
+// ==========================================================================
+// Read-only File Mappings shared across the process
+//
+// A MappedFile maps a whole file into memory read-only. Mappings are shared:
+// asking for the same path again while an earlier mapping is still referenced
+// returns that mapping, so several GlyphExtractor instances (or threads) that
+// open the same font read the same page-cache-backed bytes. On platforms
+// without mmap the file is read into a heap buffer instead.
+// ==========================================================================
+
+#include "MappedFile.h"
+#include <map>
+#include <mutex>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <fstream>
+#endif
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+namespace {
+    // every live mapping, by filename
+    mutex g_mappingLock;
+    map<string, weak_ptr<const MappedFile> > g_mappings;
+}
+
+MappedFile::MappedFile(const string &filename)
+    : m_filename(filename), m_data(0), m_size(0), m_mapped(false)
+{
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        void *data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<unsigned char *>(data);
+            m_size = info.st_size;
+            m_mapped = true;
+        }
+    }
+    close(fd);
+#else
+    ifstream input(filename.c_str(), ios::binary | ios::ate);
+    if (!input) return;
+
+    streamsize size = input.tellg();
+    if (size <= 0) return;
+
+    m_data = new unsigned char[size];
+    input.seekg(0);
+    if (input.read(reinterpret_cast<char *>(m_data), size))
+        m_size = size;
+    else {
+        delete [] m_data;
+        m_data = 0;
+    }
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+    if (m_mapped) munmap(m_data, m_size);
+#endif
+    if (!m_mapped) delete [] m_data;
+}
+
+shared_ptr<const MappedFile> MappedFile::Open(const string &filename)
+{
+    lock_guard<mutex> lock(g_mappingLock);
+
+    shared_ptr<const MappedFile> file = g_mappings[filename].lock();
+    if (file) return file;
+
+    shared_ptr<MappedFile> created(new MappedFile(filename));
+    if (!created->m_data) {
+        g_mappings.erase(filename);
+        return shared_ptr<const MappedFile>();
+    }
+    g_mappings[filename] = created;
+    return created;
+}
+
+// --------------------------------------------------------------------------
+
+PageFaults PageFaults::Now()
+{
+    PageFaults faults;
+#ifndef _WIN32
+    struct rusage usage;
+  #ifdef RUSAGE_THREAD
+    int who = RUSAGE_THREAD;
+  #else
+    int who = RUSAGE_SELF;
+  #endif
+    if (getrusage(who, &usage) == 0) {
+        faults.minor = usage.ru_minflt;
+        faults.major = usage.ru_majflt;
+    }
+#endif
+    return faults;
+}
+
+// --------------------------------------------------------------------------
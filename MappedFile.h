@@ -0,0 +1,53 @@
+// ==========================================================================
+// Read-only File Mappings shared across the process
+//
+// A MappedFile maps a whole file into memory read-only. Mappings are shared:
+// asking for the same path again while an earlier mapping is still referenced
+// returns that mapping, so several GlyphExtractor instances (or threads) that
+// open the same font read the same page-cache-backed bytes. On platforms
+// without mmap the file is read into a heap buffer instead.
+// ==========================================================================
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <memory>
+#include <string>
+
+class MappedFile
+{
+    std::string     m_filename;
+    unsigned char  *m_data;
+    size_t          m_size;
+    bool            m_mapped;   // false if the bytes live in a heap buffer
+
+    MappedFile(const std::string &filename);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+public:
+    ~MappedFile();
+
+    // returns the shared mapping for a file, or null if it cannot be read
+    static std::shared_ptr<const MappedFile> Open(const std::string &filename);
+
+    const unsigned char *Data() const   { return m_data; }
+    size_t Size() const                 { return m_size; }
+    bool Mapped() const                 { return m_mapped; }
+    const std::string &Filename() const { return m_filename; }
+};
+
+// Page fault counters for the calling thread (or process, where per-thread
+// counts are unavailable), used to measure the cost of touching mapped data.
+struct PageFaults
+{
+    long minor;
+    long major;
+
+    PageFaults() : minor(0), major(0)
+    {}
+
+    static PageFaults Now();
+};
+
+// --------------------------------------------------------------------------
+#endif // MAPPEDFILE_H
@@ -0,0 +1,112 @@
+// ==========================================================================
+// Flattened Outline Cache
+//
+// See PolylineCache.h. An entry's size is counted as the bytes of its point
+// and contour arrays plus the list node and index overhead, so the budget
+// tracks the heap the cache actually holds.
+// ==========================================================================
+
+#include "PolylineCache.h"
+#include <cmath>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+PolylineCache::PolylineCache(size_t budgetBytes)
+    : m_budget(budgetBytes), m_bytes(0), m_hits(0), m_misses(0), m_evictions(0)
+{
+}
+
+int PolylineCache::Bucket(float tolerance)
+{
+    // frexp gives tolerance = m 2^e with m in [0.5, 1), so 2^(e-1) <= tolerance
+    int exponent;
+    frexp(tolerance > 0.f ? tolerance : 1e-12f, &exponent);
+    return exponent - 1;
+}
+
+float PolylineCache::BucketTolerance(int bucket)
+{
+    return ldexp(1.f, bucket);
+}
+
+// --------------------------------------------------------------------------
+
+const Polylines *PolylineCache::Find(const Key &key)
+{
+    unordered_map<Key, EntryList::iterator, KeyHash>::iterator found = m_index.find(key);
+    if (found == m_index.end()) {
+        ++m_misses;
+        return 0;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return &found->second->polylines;
+}
+
+const Polylines &PolylineCache::Insert(const Key &key)
+{
+    m_entries.push_front(Entry());
+    Entry &entry = m_entries.front();
+    entry.key = key;
+    entry.polylines.points.assign(m_scratch.points.begin(), m_scratch.points.end());
+    entry.polylines.starts.assign(m_scratch.starts.begin(), m_scratch.starts.end());
+    entry.bytes = entry.polylines.points.capacity() * sizeof(float) +
+                  entry.polylines.starts.capacity() * sizeof(unsigned int) +
+                  sizeof(Entry) + sizeof(void *) * 4 + sizeof(Key);
+
+    m_index[key] = m_entries.begin();
+    m_bytes += entry.bytes;
+    Trim();
+    return entry.polylines;
+}
+
+void PolylineCache::Trim()
+{
+    while (m_bytes > m_budget && m_entries.size() > 1)
+    {
+        Entry &victim = m_entries.back();
+        m_bytes -= victim.bytes;
+        m_index.erase(victim.key);
+        m_entries.pop_back();
+        ++m_evictions;
+    }
+}
+
+// --------------------------------------------------------------------------
+
+const Polylines &PolylineCache::Flatten(FontHandle font, int character, const MyGlyphView &glyph,
+                                        float tolerance)
+{
+    Key key = { font, character, Bucket(tolerance) };
+    if (const Polylines *cached = Find(key)) return *cached;
+
+    Flattener::Flatten(glyph, BucketTolerance(key.bucket), m_scratch);
+    return Insert(key);
+}
+
+const Polylines &PolylineCache::Flatten(const GlyphExtractor &extractor, int character,
+                                        float tolerance)
+{
+    Key key = { extractor.ActiveFont(), character, Bucket(tolerance) };
+    if (const Polylines *cached = Find(key)) return *cached;
+
+    Flattener::Flatten(extractor.ExtractGlyph(character), BucketTolerance(key.bucket), m_scratch);
+    return Insert(key);
+}
+
+void PolylineCache::SetBudget(size_t budgetBytes)
+{
+    m_budget = budgetBytes;
+    Trim();
+}
+
+void PolylineCache::Clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+// --------------------------------------------------------------------------
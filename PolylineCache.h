@@ -0,0 +1,115 @@
+// ==========================================================================
+// Flattened Outline Cache
+//
+// Keeps the flattened polylines of glyphs that are drawn repeatedly, keyed
+// by (font, character, tolerance bucket). Buckets are powers of two: a
+// request for tolerance t is served by the outline flattened at the largest
+// power of two not above t, so zooming through a range of scales reuses a
+// handful of levels of detail per glyph while never exceeding the requested
+// tolerance. Polylines are stored in EM units, with tolerances in EM units
+// too (pixel tolerance divided by pixels per EM, see ToleranceFor).
+//
+// The cache holds at most a fixed number of bytes of polylines and evicts
+// the least recently used entries to stay within it; an entry larger than
+// the whole budget is still returned but kept only until the next request.
+// ==========================================================================
+#ifndef POLYLINECACHE_H
+#define POLYLINECACHE_H
+
+#include <list>
+#include <unordered_map>
+
+#include "Flattener.h"
+
+class PolylineCache
+{
+    struct Key
+    {
+        FontHandle  font;
+        int         character;
+        int         bucket;     // tolerance is 2^bucket EM units
+
+        bool operator==(const Key &other) const
+        { return font == other.font && character == other.character && bucket == other.bucket; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            // shifted as unsigned, since buckets are usually negative
+            typedef unsigned long long Bits;
+            return std::hash<Bits>()((Bits(unsigned(key.font)) << 48) ^
+                                     (Bits(unsigned(key.bucket)) << 32) ^ unsigned(key.character));
+        }
+    };
+
+    struct Entry
+    {
+        Key         key;
+        Polylines   polylines;
+        size_t      bytes;
+    };
+
+    // most recently used first; the map points into the list
+    typedef std::list<Entry> EntryList;
+    EntryList                                               m_entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash>   m_index;
+
+    size_t          m_budget;
+    size_t          m_bytes;
+    unsigned long   m_hits;
+    unsigned long   m_misses;
+    unsigned long   m_evictions;
+
+    // flattening output, reused so that entries can be sized exactly
+    Polylines       m_scratch;
+
+    // the entry for a key, moved to the front, or null (counting the hit
+    // or miss), and a new front entry holding a copy of m_scratch
+    const Polylines *Find(const Key &key);
+    const Polylines &Insert(const Key &key);
+
+    // drops least recently used entries, other than the newest, until the
+    // total fits the budget
+    void Trim();
+
+public:
+    explicit PolylineCache(size_t budgetBytes = 4 << 20);
+
+    // tolerance bucket of a tolerance, and the tolerance it is flattened at
+    static int Bucket(float tolerance);
+    static float BucketTolerance(int bucket);
+
+    // EM-unit tolerance for a pixel tolerance at a given on-screen EM size
+    static float ToleranceFor(float pixelsPerEM, float pixelTolerance = 0.25f)
+    { return pixelTolerance / pixelsPerEM; }
+
+    // the polylines of a character flattened within [tolerance], from the
+    // cache or by flattening [glyph] (its outline in the given font); the
+    // reference is valid until the next call that may insert or evict
+    const Polylines &Flatten(FontHandle font, int character, const MyGlyphView &glyph,
+                             float tolerance);
+
+    // the same for a character of the extractor's active font, extracting
+    // its outline only on a miss
+    const Polylines &Flatten(const GlyphExtractor &extractor, int character, float tolerance);
+
+    // changes the memory budget, evicting entries if it shrank
+    void SetBudget(size_t budgetBytes);
+    size_t Budget() const               { return m_budget; }
+
+    void Clear();
+
+    // statistics
+    size_t Size() const                 { return m_entries.size(); }
+    size_t Bytes() const                { return m_bytes; }
+    unsigned long Hits() const          { return m_hits; }
+    unsigned long Misses() const        { return m_misses; }
+    unsigned long Evictions() const     { return m_evictions; }
+    double HitRate() const
+    { return m_hits + m_misses ? double(m_hits) / double(m_hits + m_misses) : 0.0; }
+};
+
+// --------------------------------------------------------------------------
+#endif // POLYLINECACHE_H
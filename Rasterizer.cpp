@@ -0,0 +1,301 @@
+// ==========================================================================
+// Headless Software Rasterizer
+//
+// See Rasterizer.h. The stb image libraries are compiled here, the one
+// place that reads and writes image files.
+// ==========================================================================
+
+#include "Rasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "Flattener.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+Framebuffer::Framebuffer(int width, int height) : width(0), height(0)
+{
+    Resize(width, height);
+}
+
+void Framebuffer::Resize(int w, int h)
+{
+    width = max(w, 0);
+    height = max(h, 0);
+    pixels.assign(size_t(width) * height * 4, 0);
+}
+
+void Framebuffer::Clear(float r, float g, float b, float a)
+{
+    unsigned char colour[4] = {
+        (unsigned char)(min(max(r, 0.f), 1.f) * 255.f + 0.5f),
+        (unsigned char)(min(max(g, 0.f), 1.f) * 255.f + 0.5f),
+        (unsigned char)(min(max(b, 0.f), 1.f) * 255.f + 0.5f),
+        (unsigned char)(min(max(a, 0.f), 1.f) * 255.f + 0.5f) };
+    for (size_t i = 0; i < pixels.size(); i += 4)
+        copy(colour, colour + 4, &pixels[i]);
+}
+
+bool Framebuffer::WritePNG(const string &filename) const
+{
+    if (pixels.empty() || !stbi_write_png(filename.c_str(), width, height, 4, &pixels[0], width * 4)) {
+        cout << "Rasterizer ERROR: could not write " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+bool Framebuffer::ReadPNG(const string &filename)
+{
+    int w, h, channels;
+    unsigned char *data = stbi_load(filename.c_str(), &w, &h, &channels, 4);
+    if (!data) {
+        cout << "Rasterizer ERROR: could not read " << filename << endl;
+        return false;
+    }
+    width = w;
+    height = h;
+    pixels.assign(data, data + size_t(w) * h * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+int Framebuffer::MaxDifference(const Framebuffer &a, const Framebuffer &b)
+{
+    if (a.width != b.width || a.height != b.height) return 255;
+    int worst = 0;
+    for (size_t i = 0; i < a.pixels.size(); ++i)
+        worst = max(worst, abs(int(a.pixels[i]) - int(b.pixels[i])));
+    return worst;
+}
+
+// --------------------------------------------------------------------------
+
+Rasterizer::Rasterizer() : m_width(0), m_height(0), m_stride(0), m_tolerance(0.2f)
+{
+}
+
+void Rasterizer::Begin(const Framebuffer &target)
+{
+    m_width = target.width;
+    m_height = target.height;
+    m_stride = m_width + 2;
+    m_coverage.assign(size_t(m_stride) * m_height, 0.f);
+}
+
+void Rasterizer::AccumulateEdge(float *coverage, int width, int height, int stride,
+                                float x0, float y0, float x1, float y1)
+{
+    if (y0 == y1) return;
+
+    // pieces beyond the left or right border still change the winding of
+    // everything inside, so they are split off and moved onto the border
+    float borders[2] = { 0.f, float(width) };
+    for (int b = 0; b < 2; ++b)
+    {
+        float border = borders[b];
+        if ((x0 < border) != (x1 < border) && x0 != border && x1 != border) {
+            float y = y0 + (y1 - y0) * (border - x0) / (x1 - x0);
+            AccumulateEdge(coverage, width, height, stride, x0, y0, border, y);
+            AccumulateEdge(coverage, width, height, stride, border, y, x1, y1);
+            return;
+        }
+    }
+    x0 = min(max(x0, 0.f), float(width));
+    x1 = min(max(x1, 0.f), float(width));
+
+    // walk the edge downwards, one row at a time
+    float direction = 1.f;
+    if (y0 > y1) {
+        swap(x0, x1);
+        swap(y0, y1);
+        direction = -1.f;
+    }
+    float dxdy = (x1 - x0) / (y1 - y0);
+    float x = x0;
+    if (y0 < 0.f) x -= y0 * dxdy;
+
+    int rowEnd = min(height, int(ceil(y1)));
+    for (int row = max(0, int(floor(y0))); row < rowEnd; ++row)
+    {
+        float *line = coverage + size_t(row) * stride;
+        float dy = min(float(row + 1), y1) - max(float(row), y0);
+        float xNext = min(max(x + dxdy * dy, 0.f), float(width));
+        float d = dy * direction;
+
+        float left = min(x, xNext), right = max(x, xNext);
+        float leftFloor = floor(left);
+        int i0 = int(leftFloor), i1 = int(ceil(right));
+
+        if (i1 <= i0 + 1) {
+            // within one pixel: split by the edge's mean position
+            float middle = 0.5f * (x + xNext) - leftFloor;
+            line[i0]     += d - d * middle;
+            line[i0 + 1] += d * middle;
+        }
+        else {
+            // across several pixels: the area left of the edge grows
+            // quadratically in the end pixels and linearly in between
+            float s = 1.f / (right - left);
+            float leftFraction = left - leftFloor;
+            float a0 = 0.5f * s * (1.f - leftFraction) * (1.f - leftFraction);
+            float rightFraction = right - float(i1) + 1.f;
+            float am = 0.5f * s * rightFraction * rightFraction;
+            line[i0] += d * a0;
+            if (i1 == i0 + 2)
+                line[i0 + 1] += d * (1.f - a0 - am);
+            else {
+                float a1 = s * (1.5f - leftFraction);
+                line[i0 + 1] += d * (a1 - a0);
+                for (int i = i0 + 2; i < i1 - 1; ++i)
+                    line[i] += d * s;
+                float a2 = a1 + float(i1 - i0 - 3) * s;
+                line[i1 - 1] += d * (1.f - a2 - am);
+            }
+            line[i1] += d * am;
+        }
+        x = xNext;
+    }
+}
+
+// widens an edge into a rectangle with square caps when stroking; every
+// rectangle winds the same way, so overlaps add up and clamp to full coverage
+static void PushEdge(float x0, float y0, float x1, float y1, float strokeWidth,
+                     vector<RasterEdge> &edges)
+{
+    if (strokeWidth <= 0.f) {
+        RasterEdge edge = { x0, y0, x1, y1 };
+        edges.push_back(edge);
+        return;
+    }
+
+    float dx = x1 - x0, dy = y1 - y0;
+    float length = hypotf(dx, dy);
+    if (length == 0.f) return;
+
+    // half-width along and across the edge
+    float h = 0.5f * strokeWidth / length;
+    float ax = dx * h, ay = dy * h;
+    float nx = -ay, ny = ax;
+    float px[4] = { x0 - ax + nx, x1 + ax + nx, x1 + ax - nx, x0 - ax - nx };
+    float py[4] = { y0 - ay + ny, y1 + ay + ny, y1 + ay - ny, y0 - ay - ny };
+    for (int i = 0; i < 4; ++i) {
+        RasterEdge edge = { px[i], py[i], px[(i + 1) % 4], py[(i + 1) % 4] };
+        edges.push_back(edge);
+    }
+}
+
+void Rasterizer::StreamEdges(const float *vertices, size_t count, int degree, float strokeWidth,
+                             int width, int height, float tolerance, vector<RasterEdge> &edges)
+{
+    int stride = degree == 1 ? GlyphGeometry::LINE_VERTICES : GlyphGeometry::PATCH_VERTICES;
+    float sx = 0.5f * width, sy = -0.5f * height;
+
+    for (size_t i = 0; i + stride <= count; i += stride)
+    {
+        // control points in pixels, +y down
+        const float *patch = vertices + 2 * i;
+        float x[4], y[4];
+        for (int v = 0; v <= degree; ++v) {
+            x[v] = (patch[2*v] + 1.f) * sx;
+            y[v] = (patch[2*v + 1] - 1.f) * sy;
+        }
+
+        if (degree == 1) {
+            PushEdge(x[0], y[0], x[1], y[1], strokeWidth, edges);
+            continue;
+        }
+
+        int steps = degree == 2 ? Flattener::QuadraticSteps(x, y, tolerance)
+                                : Flattener::CubicSteps(x, y, tolerance);
+        float lastX = x[0], lastY = y[0];
+        for (int k = 1; k <= steps; ++k)
+        {
+            float u = float(k) / steps, b = 1.f - u, px, py;
+            if (k == steps) {
+                px = x[degree];
+                py = y[degree];
+            }
+            else if (degree == 2) {
+                float w0 = b * b, w1 = 2.f * b * u, w2 = u * u;
+                px = w0 * x[0] + w1 * x[1] + w2 * x[2];
+                py = w0 * y[0] + w1 * y[1] + w2 * y[2];
+            }
+            else {
+                float w0 = b * b * b, w1 = 3.f * b * b * u, w2 = 3.f * b * u * u, w3 = u * u * u;
+                px = w0 * x[0] + w1 * x[1] + w2 * x[2] + w3 * x[3];
+                py = w0 * y[0] + w1 * y[1] + w2 * y[2] + w3 * y[3];
+            }
+            PushEdge(lastX, lastY, px, py, strokeWidth, edges);
+            lastX = px;
+            lastY = py;
+        }
+    }
+}
+
+void Rasterizer::ResolveRow(float *coverage, int count, int stride, unsigned char *pixel,
+                            const float colour[4])
+{
+    float winding = 0.f;
+    for (int i = 0; i < count; ++i, pixel += 4)
+    {
+        winding += coverage[i];
+        float alpha = min(fabs(winding), 1.f) * colour[3];
+        if (alpha <= 0.f) continue;
+        for (int c = 0; c < 3; ++c)
+            pixel[c] = (unsigned char)(pixel[c] + (colour[c] * 255.f - pixel[c]) * alpha + 0.5f);
+        pixel[3] = (unsigned char)(pixel[3] + (255.f - pixel[3]) * alpha + 0.5f);
+    }
+    fill(coverage, coverage + stride, 0.f);
+}
+
+// --------------------------------------------------------------------------
+
+void Rasterizer::AddStream(const float *vertices, size_t count, int degree, float width)
+{
+    if (m_coverage.empty()) return;
+
+    m_edges.clear();
+    StreamEdges(vertices, count, degree, width, m_width, m_height, m_tolerance, m_edges);
+    for (size_t i = 0; i < m_edges.size(); ++i) {
+        const RasterEdge &edge = m_edges[i];
+        AccumulateEdge(&m_coverage[0], m_width, m_height, m_stride, edge.x0, edge.y0, edge.x1, edge.y1);
+    }
+}
+
+void Rasterizer::Fill(const GlyphGeometry &geometry)
+{
+    FillStream(geometry.Lines(), geometry.LineVertices(), 1);
+    FillStream(geometry.Quadratics(), geometry.QuadraticVertices(), 2);
+    FillStream(geometry.Cubics(), geometry.CubicVertices(), 3);
+}
+
+void Rasterizer::Stroke(const GlyphGeometry &geometry, float width)
+{
+    StrokeStream(geometry.Lines(), geometry.LineVertices(), 1, width);
+    StrokeStream(geometry.Quadratics(), geometry.QuadraticVertices(), 2, width);
+    StrokeStream(geometry.Cubics(), geometry.CubicVertices(), 3, width);
+}
+
+void Rasterizer::Resolve(Framebuffer &target, float r, float g, float b, float a)
+{
+    if (target.width != m_width || target.height != m_height) {
+        cout << "Rasterizer ERROR: framebuffer size changed since Begin." << endl;
+        return;
+    }
+
+    float colour[4] = { r, g, b, a };
+    for (int row = 0; row < m_height; ++row)
+        ResolveRow(&m_coverage[size_t(row) * m_stride], m_width, m_stride,
+                   &target.pixels[size_t(row) * m_width * 4], colour);
+}
+
+// --------------------------------------------------------------------------
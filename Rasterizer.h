@@ -0,0 +1,113 @@
+// ==========================================================================
+// Headless Software Rasterizer
+//
+// Renders the line, quadratic and cubic patch streams of a GlyphGeometry
+// (or the scenes' raw vertex arrays) into an RGBA8 framebuffer on the CPU,
+// so text can be rendered and checked against golden images without a GL
+// context. Coordinates are in clip space and map onto the framebuffer as
+// the GL viewport does, with +y up.
+//
+// Curves are flattened in pixel space to within a fraction of a pixel (see
+// Flattener), and each resulting edge adds its exact signed area to a
+// coverage accumulation buffer. Summing a row of that buffer gives the
+// anti-aliased winding coverage of every pixel, as in font-rs. Two modes
+// are supported:
+//  - fill: the edges of closed outlines are accumulated as they are, and
+//    coverage is the nonzero winding number clamped to one;
+//  - stroke: every edge is widened into a rectangle with square caps and
+//    the union of the rectangles is filled, which draws the outline as
+//    the scenes do with lines of a given width in pixels.
+// Accumulated coverage is composited over the framebuffer in one colour by
+// Resolve; several passes can be layered in different colours.
+// ==========================================================================
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include <string>
+#include <vector>
+
+#include "GlyphGeometry.h"
+
+// an RGBA8 image, rows stored top to bottom
+struct Framebuffer
+{
+    int                         width;
+    int                         height;
+    std::vector<unsigned char>  pixels;
+
+    Framebuffer(int width = 0, int height = 0);
+
+    void Resize(int width, int height);
+    void Clear(float r, float g, float b, float a = 1.f);
+
+    // saves as PNG, or loads a PNG as RGBA8, returning false on failure
+    bool WritePNG(const std::string &filename) const;
+    bool ReadPNG(const std::string &filename);
+
+    // largest per-channel difference to another image of the same size,
+    // or 255 if the sizes differ
+    static int MaxDifference(const Framebuffer &a, const Framebuffer &b);
+};
+
+// one straight edge in pixels, +y down
+struct RasterEdge
+{
+    float x0, y0, x1, y1;
+};
+
+class Rasterizer
+{
+    // signed area accumulated per pixel; each row has two spare entries so
+    // that edges clamped to the right border never wrap into the next row
+    std::vector<float>  m_coverage;
+    int                 m_width;
+    int                 m_height;
+    int                 m_stride;
+
+    float               m_tolerance;    // flattening tolerance, pixels
+
+    // edges of the stream being added, reused between calls
+    std::vector<RasterEdge> m_edges;
+
+    void AddStream(const float *vertices, size_t count, int degree, float width);
+
+public:
+    Rasterizer();
+
+    // sizes the accumulation buffer for a target and clears it
+    void Begin(const Framebuffer &target);
+
+    // flattening tolerance in pixels (default 0.2)
+    void SetTolerance(float pixels)     { m_tolerance = pixels; }
+    float Tolerance() const             { return m_tolerance; }
+
+    // adds a stream of 2-vertex straight segments (degree 1) or of 4-vertex
+    // curve patches (degree 2 or 3), filled, or stroked [width] pixels wide
+    void FillStream(const float *vertices, size_t count, int degree)
+    { AddStream(vertices, count, degree, 0.f); }
+    void StrokeStream(const float *vertices, size_t count, int degree, float width)
+    { AddStream(vertices, count, degree, width); }
+
+    // adds every stream of a geometry
+    void Fill(const GlyphGeometry &geometry);
+    void Stroke(const GlyphGeometry &geometry, float width);
+
+    // composites the accumulated coverage over the target in the given
+    // colour and clears the accumulation for the next pass
+    void Resolve(Framebuffer &target, float r, float g, float b, float a = 1.f);
+
+    // the steps shared with TiledRasterizer: flattening a stream in clip
+    // space into pixel edges for a width x height target (stroked edges
+    // become rectangles), adding the signed area of an edge to a coverage
+    // buffer of the given size and row stride (at least width + 2), and
+    // compositing one row of coverage, then clearing [stride] entries of it
+    static void StreamEdges(const float *vertices, size_t count, int degree, float strokeWidth,
+                            int width, int height, float tolerance, std::vector<RasterEdge> &edges);
+    static void AccumulateEdge(float *coverage, int width, int height, int stride,
+                               float x0, float y0, float x1, float y1);
+    static void ResolveRow(float *coverage, int count, int stride, unsigned char *pixels,
+                           const float colour[4]);
+};
+
+// --------------------------------------------------------------------------
+#endif // RASTERIZER_H
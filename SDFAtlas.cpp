@@ -0,0 +1,463 @@
+// ==========================================================================
+// Signed Distance Field Atlas
+//
+// See SDFAtlas.h. Distances are worked out in doubles, in pixels relative
+// to the lower left corner of the glyph's window, with +y up.
+// ==========================================================================
+
+#include "SDFAtlas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include <stb_image_write.h>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+namespace
+{
+    // a segment in pixels with its control point bounds, which contain it
+    struct Segment
+    {
+        int     degree;
+        double  x[4], y[4];
+        double  minX, minY, maxX, maxY;
+
+        void Point(double t, double &px, double &py) const;
+        void Derivative(double t, double &dx, double &dy) const;
+    };
+
+    // a piece of a segment over which y only rises or only falls, for
+    // finding where rows of pixel centres cross the outline
+    struct Monotone
+    {
+        unsigned int    segment;
+        double          t0, t1;
+        double          y0, y1;
+    };
+
+    struct Crossing
+    {
+        double  x;
+        int     direction;
+
+        bool operator<(const Crossing &other) const { return x < other.x; }
+    };
+
+    const double EPSILON = 1e-12;
+}
+
+void Segment::Point(double t, double &px, double &py) const
+{
+    double s = 1.0 - t;
+    if (degree == 1) {
+        px = s * x[0] + t * x[1];
+        py = s * y[0] + t * y[1];
+    }
+    else if (degree == 2) {
+        double w0 = s * s, w1 = 2.0 * s * t, w2 = t * t;
+        px = w0 * x[0] + w1 * x[1] + w2 * x[2];
+        py = w0 * y[0] + w1 * y[1] + w2 * y[2];
+    }
+    else {
+        double w0 = s * s * s, w1 = 3.0 * s * s * t, w2 = 3.0 * s * t * t, w3 = t * t * t;
+        px = w0 * x[0] + w1 * x[1] + w2 * x[2] + w3 * x[3];
+        py = w0 * y[0] + w1 * y[1] + w2 * y[2] + w3 * y[3];
+    }
+}
+
+void Segment::Derivative(double t, double &dx, double &dy) const
+{
+    double s = 1.0 - t;
+    if (degree == 1) {
+        dx = x[1] - x[0];
+        dy = y[1] - y[0];
+    }
+    else if (degree == 2) {
+        dx = 2.0 * (s * (x[1] - x[0]) + t * (x[2] - x[1]));
+        dy = 2.0 * (s * (y[1] - y[0]) + t * (y[2] - y[1]));
+    }
+    else {
+        double w0 = s * s, w1 = 2.0 * s * t, w2 = t * t;
+        dx = 3.0 * (w0 * (x[1] - x[0]) + w1 * (x[2] - x[1]) + w2 * (x[3] - x[2]));
+        dy = 3.0 * (w0 * (y[1] - y[0]) + w1 * (y[2] - y[1]) + w2 * (y[3] - y[2]));
+    }
+}
+
+// real roots of a x^2 + b x + c and of a x^3 + b x^2 + c x + d, returning
+// how many were written; degenerate leading terms fall to lower degrees
+static int SolveQuadratic(double roots[2], double a, double b, double c)
+{
+    if (fabs(a) < EPSILON) {
+        if (fabs(b) < EPSILON) return 0;
+        roots[0] = -c / b;
+        return 1;
+    }
+    double discriminant = b * b - 4.0 * a * c;
+    if (discriminant < 0.0) return 0;
+    if (discriminant == 0.0) {
+        roots[0] = -0.5 * b / a;
+        return 1;
+    }
+    // the stable form, avoiding cancellation between -b and the root
+    double q = -0.5 * (b + (b < 0.0 ? -sqrt(discriminant) : sqrt(discriminant)));
+    roots[0] = q / a;
+    roots[1] = c / q;
+    return 2;
+}
+
+static int SolveCubic(double roots[3], double a, double b, double c, double d)
+{
+    if (fabs(a) < EPSILON * (fabs(b) + fabs(c) + fabs(d)) || a == 0.0)
+        return SolveQuadratic(roots, b, c, d);
+
+    // depressed cubic t^3 + p t + q in t = x + b / 3
+    b /= a;
+    c /= a;
+    d /= a;
+    double b3 = b / 3.0;
+    double p = c - b * b3;
+    double q = 2.0 * b3 * b3 * b3 - b3 * c + d;
+    double discriminant = 0.25 * q * q + p * p * p / 27.0;
+
+    if (discriminant > 0.0) {
+        double r = sqrt(discriminant);
+        roots[0] = cbrt(-0.5 * q + r) + cbrt(-0.5 * q - r) - b3;
+        return 1;
+    }
+    if (p == 0.0) {
+        roots[0] = -b3;
+        return 1;
+    }
+    // three real roots, by the trigonometric method
+    double m = 2.0 * sqrt(-p / 3.0);
+    double angle = acos(max(-1.0, min(1.0, 3.0 * q / (p * m)))) / 3.0;
+    for (int k = 0; k < 3; ++k)
+        roots[k] = m * cos(angle - 2.0 * M_PI * k / 3.0) - b3;
+    return 3;
+}
+
+// squared distance from (px, py) to a segment
+static double SquaredDistance(const Segment &segment, double px, double py)
+{
+    const double *x = segment.x, *y = segment.y;
+    int degree = segment.degree;
+    double ex = x[degree] - px, ey = y[degree] - py;
+    double best = min((x[0] - px) * (x[0] - px) + (y[0] - py) * (y[0] - py), ex * ex + ey * ey);
+
+    if (degree == 1) {
+        double dx = x[1] - x[0], dy = y[1] - y[0];
+        double length = dx * dx + dy * dy;
+        if (length > 0.0) {
+            double t = ((px - x[0]) * dx + (py - y[0]) * dy) / length;
+            if (t > 0.0 && t < 1.0) {
+                double cx = x[0] + t * dx - px, cy = y[0] + t * dy - py;
+                best = min(best, cx * cx + cy * cy);
+            }
+        }
+        return best;
+    }
+
+    if (degree == 2) {
+        // the closest points zero (B(t) - p).B'(t), a cubic in t
+        double qx = x[0] - px, qy = y[0] - py;
+        double ax = x[1] - x[0], ay = y[1] - y[0];
+        double bx = x[2] - x[1] - ax, by = y[2] - y[1] - ay;
+        double roots[3];
+        int count = SolveCubic(roots, bx * bx + by * by, 3.0 * (ax * bx + ay * by),
+                               2.0 * (ax * ax + ay * ay) + qx * bx + qy * by, qx * ax + qy * ay);
+        for (int r = 0; r < count; ++r)
+        {
+            double t = roots[r];
+            if (t <= 0.0 || t >= 1.0) continue;
+            double cx = qx + t * (2.0 * ax + t * bx), cy = qy + t * (2.0 * ay + t * by);
+            best = min(best, cx * cx + cy * cy);
+        }
+        return best;
+    }
+
+    // cubics: Newton's method on (B(t) - p).B'(t) from several starts
+    for (int start = 0; start <= 4; ++start)
+    {
+        double t = 0.25 * start;
+        for (int step = 0; step < 4; ++step)
+        {
+            double bx, by, dx, dy;
+            segment.Point(t, bx, by);
+            segment.Derivative(t, dx, dy);
+            bx -= px;
+            by -= py;
+            double s = 1.0 - t;
+            double ddx = 6.0 * (s * (x[2] - 2.0 * x[1] + x[0]) + t * (x[3] - 2.0 * x[2] + x[1]));
+            double ddy = 6.0 * (s * (y[2] - 2.0 * y[1] + y[0]) + t * (y[3] - 2.0 * y[2] + y[1]));
+            double f = bx * dx + by * dy;
+            double df = dx * dx + dy * dy + bx * ddx + by * ddy;
+            if (df == 0.0) break;
+            t = min(1.0, max(0.0, t - f / df));
+        }
+        double bx, by;
+        segment.Point(t, bx, by);
+        best = min(best, (bx - px) * (bx - px) + (by - py) * (by - py));
+    }
+    return best;
+}
+
+// squared distance from (px, py) to a segment's bounds, a lower bound on
+// its squared distance to the segment
+static double BoundsDistance(const Segment &segment, double px, double py)
+{
+    double dx = max(0.0, max(segment.minX - px, px - segment.maxX));
+    double dy = max(0.0, max(segment.minY - py, py - segment.maxY));
+    return dx * dx + dy * dy;
+}
+
+// y at t of one coordinate of a segment, for the crossing search
+static double CoordinateAt(const Segment &segment, const double *c, double t)
+{
+    double s = 1.0 - t;
+    if (segment.degree == 1) return s * c[0] + t * c[1];
+    if (segment.degree == 2) return s * s * c[0] + 2.0 * s * t * c[1] + t * t * c[2];
+    return s * s * s * c[0] + 3.0 * s * t * (s * c[1] + t * c[2]) + t * t * t * c[3];
+}
+
+// --------------------------------------------------------------------------
+
+SDFAtlas::SDFAtlas(float pixelsPerEM, float range) :
+    m_pixelsPerEM(pixelsPerEM), m_range(range), m_width(0), m_height(0)
+{
+}
+
+void SDFAtlas::Generate(const MyGlyph &glyph, float pixelsPerEM, float range, float left,
+                        float bottom, int width, int height, unsigned char *pixels, size_t stride)
+{
+    // segments in pixels, split into pieces monotonic in y
+    vector<Segment> segments;
+    vector<Monotone> pieces;
+    for (size_t c = 0; c < glyph.contours.size(); ++c)
+    {
+        const MyContour &contour = glyph.contours[c];
+        if (contour.empty()) continue;
+
+        // some fonts leave a contour open by a hair; it is closed with a
+        // line, as the nonzero rule assumes closed contours
+        const MySegment &first = contour.front(), &last = contour.back();
+        MySegment closing(1);
+        closing.x[0] = last.x[min(last.degree, 3u)];
+        closing.y[0] = last.y[min(last.degree, 3u)];
+        closing.x[1] = first.x[0];
+        closing.y[1] = first.y[0];
+        bool open = closing.x[0] != closing.x[1] || closing.y[0] != closing.y[1];
+
+        for (size_t s = 0; s < contour.size() + (open ? 1 : 0); ++s)
+        {
+            const MySegment &source = s < contour.size() ? contour[s] : closing;
+            if (source.degree < 1 || source.degree > 3) continue;
+            Segment segment;
+            segment.degree = source.degree;
+            segment.minX = segment.minY = HUGE_VAL;
+            segment.maxX = segment.maxY = -HUGE_VAL;
+            for (int v = 0; v <= segment.degree; ++v) {
+                segment.x[v] = (double(source.x[v]) - left) * pixelsPerEM;
+                segment.y[v] = (double(source.y[v]) - bottom) * pixelsPerEM;
+                segment.minX = min(segment.minX, segment.x[v]);
+                segment.maxX = max(segment.maxX, segment.x[v]);
+                segment.minY = min(segment.minY, segment.y[v]);
+                segment.maxY = max(segment.maxY, segment.y[v]);
+            }
+
+            // y'(t) is at most quadratic; its roots inside (0, 1) split the segment
+            double roots[2], splits[4] = { 0.0 };
+            int count = 0, kept = 1;
+            const double *y = segment.y;
+            if (segment.degree == 2)
+                count = SolveQuadratic(roots, 0.0, y[0] - 2.0 * y[1] + y[2], y[1] - y[0]);
+            else if (segment.degree == 3)
+                count = SolveQuadratic(roots, -y[0] + 3.0 * y[1] - 3.0 * y[2] + y[3],
+                                       2.0 * (y[0] - 2.0 * y[1] + y[2]), y[1] - y[0]);
+            if (count == 2 && roots[1] < roots[0]) swap(roots[0], roots[1]);
+            for (int r = 0; r < count; ++r)
+                if (roots[r] > splits[kept - 1] && roots[r] < 1.0) splits[kept++] = roots[r];
+            splits[kept] = 1.0;
+
+            for (int r = 0; r < kept; ++r) {
+                Monotone piece = { unsigned(segments.size()), splits[r], splits[r + 1],
+                                   CoordinateAt(segment, y, splits[r]), CoordinateAt(segment, y, splits[r + 1]) };
+                if (piece.y0 != piece.y1) pieces.push_back(piece);
+            }
+            segments.push_back(segment);
+        }
+    }
+
+    double limit = double(range) * range;
+    vector<Crossing> crossings;
+    for (int row = 0; row < height; ++row)
+    {
+        unsigned char *line = pixels + size_t(row) * stride;
+        double py = height - row - 0.5;
+
+        // crossings of this row of centres; each piece covers heights
+        // [low, high), so a row through a joint is counted once
+        crossings.clear();
+        for (size_t p = 0; p < pieces.size(); ++p)
+        {
+            const Monotone &piece = pieces[p];
+            bool rising = piece.y0 < piece.y1;
+            double low = rising ? piece.y0 : piece.y1, high = rising ? piece.y1 : piece.y0;
+            if (py < low || py >= high) continue;
+
+            const Segment &segment = segments[piece.segment];
+            double t0 = piece.t0, t1 = piece.t1;
+            for (int i = 0; i < 40 && t1 - t0 > 1e-12; ++i) {
+                double t = 0.5 * (t0 + t1);
+                if ((CoordinateAt(segment, segment.y, t) < py) == rising) t0 = t;
+                else t1 = t;
+            }
+            Crossing crossing = { CoordinateAt(segment, segment.x, 0.5 * (t0 + t1)), rising ? 1 : -1 };
+            crossings.push_back(crossing);
+        }
+        sort(crossings.begin(), crossings.end());
+
+        size_t next = 0, nearest = 0;
+        int winding = 0;
+        for (int column = 0; column < width; ++column)
+        {
+            double px = column + 0.5;
+            while (next < crossings.size() && crossings[next].x <= px)
+                winding += crossings[next++].direction;
+
+            // the nearest segment of the previous pixel first, as it is
+            // likely to be near this one and tightens the bound early
+            double best = limit;
+            if (nearest < segments.size() && BoundsDistance(segments[nearest], px, py) < best)
+                best = min(best, SquaredDistance(segments[nearest], px, py));
+            for (size_t s = 0; s < segments.size(); ++s)
+            {
+                if (s == nearest || BoundsDistance(segments[s], px, py) >= best) continue;
+                double distance = SquaredDistance(segments[s], px, py);
+                if (distance < best) {
+                    best = distance;
+                    nearest = s;
+                }
+            }
+
+            double signedDistance = winding != 0 ? sqrt(best) : -sqrt(best);
+            double value = 127.5 + 127.5 * max(-1.0, min(1.0, signedDistance / range));
+            line[column] = (unsigned char)(value + 0.5);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+
+void SDFAtlas::Build(const int *characters, const MyGlyph *glyphs, size_t count, WorkStealingPool &pool)
+{
+    // windows around the control point bounds, padded so that the border
+    // pixels lie beyond the range and sample as far outside
+    float padding = ceil(m_range) + 1.f;
+    m_glyphs.assign(count, SDFGlyph());
+    for (size_t i = 0; i < count; ++i)
+    {
+        SDFGlyph &entry = m_glyphs[i];
+        entry.character = characters[i];
+        entry.advance = glyphs[i].advance;
+        entry.x = entry.y = entry.width = entry.height = 0;
+        entry.left = entry.bottom = entry.right = entry.top = 0.f;
+
+        float minX = HUGE_VALF, minY = HUGE_VALF, maxX = -HUGE_VALF, maxY = -HUGE_VALF;
+        for (size_t c = 0; c < glyphs[i].contours.size(); ++c)
+            for (size_t s = 0; s < glyphs[i].contours[c].size(); ++s) {
+                const MySegment &segment = glyphs[i].contours[c][s];
+                for (unsigned int v = 0; v <= segment.degree && v < 4; ++v) {
+                    minX = min(minX, segment.x[v]);
+                    maxX = max(maxX, segment.x[v]);
+                    minY = min(minY, segment.y[v]);
+                    maxY = max(maxY, segment.y[v]);
+                }
+            }
+        if (minX > maxX) continue;
+
+        float x0 = floor(minX * m_pixelsPerEM) - padding, x1 = ceil(maxX * m_pixelsPerEM) + padding;
+        float y0 = floor(minY * m_pixelsPerEM) - padding, y1 = ceil(maxY * m_pixelsPerEM) + padding;
+        entry.width = int(x1 - x0);
+        entry.height = int(y1 - y0);
+        entry.left = x0 / m_pixelsPerEM;
+        entry.right = x1 / m_pixelsPerEM;
+        entry.bottom = y0 / m_pixelsPerEM;
+        entry.top = y1 / m_pixelsPerEM;
+    }
+
+    // shelves of glyphs in order of decreasing height, in a power of two
+    // width near the square root of their total area
+    vector<size_t> order(count);
+    size_t area = 0;
+    int widest = 1;
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = i;
+        area += size_t(m_glyphs[i].width) * m_glyphs[i].height;
+        widest = max(widest, m_glyphs[i].width);
+    }
+    sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        const SDFGlyph &ga = m_glyphs[a], &gb = m_glyphs[b];
+        return ga.height != gb.height ? ga.height > gb.height : ga.width > gb.width; });
+
+    m_width = 1;
+    while (double(m_width) * m_width < 1.1 * area || m_width < widest) m_width *= 2;
+    int x = 0, y = 0, shelf = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        SDFGlyph &entry = m_glyphs[order[i]];
+        if (entry.width == 0) continue;
+        if (x + entry.width > m_width) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+        entry.x = x;
+        entry.y = y;
+        x += entry.width;
+        shelf = max(shelf, entry.height);
+    }
+    m_height = y + shelf;
+    m_pixels.assign(size_t(m_width) * m_height, 0);
+
+    // the tallest glyphs go first, so the pool ends on short tasks
+    pool.Run(count, [&](size_t task, unsigned int) {
+        const SDFGlyph &entry = m_glyphs[order[task]];
+        if (entry.width == 0) return;
+        Generate(glyphs[order[task]], m_pixelsPerEM, m_range, entry.left, entry.bottom,
+                 entry.width, entry.height, &m_pixels[size_t(entry.y) * m_width + entry.x], m_width);
+    });
+}
+
+bool SDFAtlas::WritePNG(const string &filename) const
+{
+    if (m_pixels.empty() || !stbi_write_png(filename.c_str(), m_width, m_height, 1, &m_pixels[0], m_width)) {
+        cout << "SDFAtlas ERROR: could not write " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+bool SDFAtlas::WriteMetrics(const string &filename) const
+{
+    FILE *file = fopen(filename.c_str(), "w");
+    if (!file) {
+        cout << "SDFAtlas ERROR: could not write " << filename << endl;
+        return false;
+    }
+    fprintf(file, "# sdf atlas %d %d, %.9g pixels per EM, range %.9g pixels\n",
+            m_width, m_height, m_pixelsPerEM, m_range);
+    fprintf(file, "# character advance x y width height left bottom right top\n");
+    for (size_t i = 0; i < m_glyphs.size(); ++i)
+    {
+        const SDFGlyph &g = m_glyphs[i];
+        fprintf(file, "%d %.9g %d %d %d %d %.9g %.9g %.9g %.9g\n", g.character, g.advance,
+                g.x, g.y, g.width, g.height, g.left, g.bottom, g.right, g.top);
+    }
+    return fclose(file) == 0;
+}
+
+// --------------------------------------------------------------------------
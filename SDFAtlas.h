@@ -0,0 +1,77 @@
+// ==========================================================================
+// Signed Distance Field Atlas
+//
+// Computes signed distance fields of a set of glyphs straight from their
+// Bezier outlines, not from rasterized bitmaps, and packs them into one
+// 8-bit atlas, so text can be drawn as textured quads at any scale.
+//  - Distance: every pixel centre takes its distance to the nearest
+//    segment, exact for lines and for quadratics (the real roots of the
+//    cubic whose zeros are the closest points) and found by Newton
+//    iteration from several starts for cubics. Segments whose bounding
+//    box is farther than the best distance so far, or than the field's
+//    range, are skipped.
+//  - Sign: the nonzero winding number, from the exact crossings of the
+//    outline with each row of pixel centres, found once per row.
+//  - Encoding: 127.5 + 127.5 d / range, clamped, with d in pixels and
+//    positive inside, so the outline lies at the 0.5 level.
+// Glyphs are packed onto shelves in order of decreasing height, in an atlas
+// whose width is the power of two nearest a square layout, and computed in
+// parallel on a WorkStealingPool, each glyph writing only its own rectangle.
+// ==========================================================================
+#ifndef SDFATLAS_H
+#define SDFATLAS_H
+
+#include <string>
+#include <vector>
+
+#include "GlyphExtractor.h"
+#include "WorkStealingPool.h"
+
+// where a glyph lies in the atlas, and where its rectangle goes around the
+// glyph origin when it is drawn
+struct SDFGlyph
+{
+    int     character;
+    float   advance;                    // EM units
+    int     x, y, width, height;        // pixels, rows top down; empty for blank glyphs
+    float   left, bottom, right, top;   // EM units
+};
+
+class SDFAtlas
+{
+    float                       m_pixelsPerEM;
+    float                       m_range;        // pixels from the outline to 0 or 255
+    int                         m_width;
+    int                         m_height;
+    std::vector<unsigned char>  m_pixels;
+    std::vector<SDFGlyph>       m_glyphs;
+
+public:
+    SDFAtlas(float pixelsPerEM = 32.f, float range = 4.f);
+
+    // the field of one glyph over a width x height window whose lower left
+    // corner lies at (left, bottom) in EM units, written top row first with
+    // [stride] bytes between rows
+    static void Generate(const MyGlyph &glyph, float pixelsPerEM, float range, float left,
+                         float bottom, int width, int height, unsigned char *pixels, size_t stride);
+
+    // lays out and computes the atlas of glyphs[i] (the outline of
+    // characters[i]) for every i below [count], spread over the pool
+    void Build(const int *characters, const MyGlyph *glyphs, size_t count, WorkStealingPool &pool);
+
+    // saves the atlas as a greyscale PNG, and the metrics as text with one
+    // glyph per line, returning false on failure
+    bool WritePNG(const std::string &filename) const;
+    bool WriteMetrics(const std::string &filename) const;
+
+    float PixelsPerEM() const           { return m_pixelsPerEM; }
+    float Range() const                 { return m_range; }
+    int Width() const                   { return m_width; }
+    int Height() const                  { return m_height; }
+    const unsigned char *Pixels() const { return m_pixels.empty() ? 0 : &m_pixels[0]; }
+    size_t Bytes() const                { return m_pixels.size(); }
+    const std::vector<SDFGlyph> &Glyphs() const { return m_glyphs; }
+};
+
+// --------------------------------------------------------------------------
+#endif // SDFATLAS_H
@@ -0,0 +1,162 @@
+// ==========================================================================
+// CPU Reference Tessellator
+//
+// See Tessellator.h. The level and evaluation code mirror tessControl.glsl
+// and tessEval.glsl line for line; keep them in step with the shaders.
+// ==========================================================================
+
+#include "Tessellator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+bool Polylines::Write(const string &filename) const
+{
+    FILE *file = fopen(filename.c_str(), "w");
+    if (!file) {
+        cout << "Tessellator ERROR: could not write " << filename << endl;
+        return false;
+    }
+    for (size_t i = 0; i < Count(); ++i)
+    {
+        fprintf(file, "%u", starts[i + 1] - starts[i]);
+        for (unsigned int p = starts[i]; p < starts[i + 1]; ++p)
+            fprintf(file, " %.9g %.9g", points[2*p], points[2*p + 1]);
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+bool Polylines::Read(const string &filename)
+{
+    Clear();
+    ifstream input(filename.c_str());
+    if (!input) {
+        cout << "Tessellator ERROR: could not read " << filename << endl;
+        return false;
+    }
+
+    string line;
+    while (getline(input, line))
+    {
+        istringstream fields(line);
+        unsigned int count;
+        if (!(fields >> count)) continue;
+        for (unsigned int p = 0; p < count; ++p)
+        {
+            float x, y;
+            if (!(fields >> x >> y)) {
+                cout << "Tessellator ERROR: " << filename << " is truncated." << endl;
+                Clear();
+                return false;
+            }
+            points.push_back(x);
+            points.push_back(y);
+        }
+        starts.push_back(PointCount());
+    }
+    return true;
+}
+
+bool Polylines::Compare(const Polylines &a, const Polylines &b, float tolerance, float *maxError)
+{
+    if (maxError) *maxError = 0.f;
+    if (a.starts != b.starts) return false;
+
+    float worst = 0.f;
+    for (size_t i = 0; i < a.points.size(); ++i)
+        worst = max(worst, fabs(a.points[i] - b.points[i]));
+    if (maxError) *maxError = worst;
+    return worst <= tolerance;
+}
+
+// --------------------------------------------------------------------------
+
+float PatchTessellator::Level(const float *patch, int degree, const TessellationSettings &settings)
+{
+    if (!settings.adaptive) return min(settings.fixedLevel, settings.maxLevel);
+
+    // control points in pixels
+    float x[4], y[4];
+    for (int i = 0; i < 4; ++i) {
+        x[i] = patch[2*i] * 0.5f * settings.viewportWidth;
+        y[i] = patch[2*i + 1] * 0.5f * settings.viewportHeight;
+    }
+
+    float flatness = hypotf(x[0] - 2.f * x[1] + x[2], y[0] - 2.f * y[1] + y[2]);
+    float polygon = hypotf(x[1] - x[0], y[1] - y[0]) + hypotf(x[2] - x[1], y[2] - y[1]);
+    if (degree == 3) {
+        flatness = max(flatness, hypotf(x[1] - 2.f * x[2] + x[3], y[1] - 2.f * y[2] + y[3]));
+        polygon += hypotf(x[3] - x[2], y[3] - y[2]);
+    }
+
+    float wang = ceil(sqrt(float(degree * (degree - 1)) / 8.f * flatness / settings.pixelTolerance));
+    return min(max(min(wang, ceil(polygon)), 1.f), settings.maxLevel);
+}
+
+void PatchTessellator::Evaluate(const float *patch, int degree, float u, float &x, float &y)
+{
+    float b0 = 1.f - u, b1 = u;
+    const float *p0 = patch, *p1 = patch + 2, *p2 = patch + 4, *p3 = patch + 6;
+    if (degree == 2) {
+        float w0 = b0 * b0, w1 = 2.f * b0 * b1, w2 = b1 * b1;
+        x = w0 * p0[0] + w1 * p1[0] + w2 * p2[0];
+        y = w0 * p0[1] + w1 * p1[1] + w2 * p2[1];
+    }
+    else if (degree == 3) {
+        float w0 = b0 * b0 * b0, w1 = 3.f * b0 * b0 * b1, w2 = 3.f * b0 * b1 * b1, w3 = b1 * b1 * b1;
+        x = w0 * p0[0] + w1 * p1[0] + w2 * p2[0] + w3 * p3[0];
+        y = w0 * p0[1] + w1 * p1[1] + w2 * p2[1] + w3 * p3[1];
+    }
+    else {
+        x = b0 * p0[0] + b1 * p1[0];
+        y = b0 * p0[1] + b1 * p1[1];
+    }
+}
+
+void PatchTessellator::TessellateStream(const float *vertices, size_t count, int degree,
+                                        const TessellationSettings &settings, Polylines &output)
+{
+    if (degree == 1)
+    {
+        // straight segments skip tessellation and are drawn as GL_LINES
+        output.points.insert(output.points.end(), vertices, vertices + 2 * count);
+        for (size_t i = 0; i + GlyphGeometry::LINE_VERTICES <= count; i += GlyphGeometry::LINE_VERTICES)
+            output.starts.push_back(output.starts.back() + GlyphGeometry::LINE_VERTICES);
+        return;
+    }
+
+    for (size_t i = 0; i + GlyphGeometry::PATCH_VERTICES <= count; i += GlyphGeometry::PATCH_VERTICES)
+    {
+        const float *patch = vertices + 2 * i;
+
+        // equal spacing rounds the level up to a whole number of pieces
+        int level = int(ceil(Level(patch, degree, settings)));
+        for (int k = 0; k <= level; ++k)
+        {
+            float x, y;
+            Evaluate(patch, degree, float(k) / float(level), x, y);
+            output.points.push_back(x);
+            output.points.push_back(y);
+        }
+        output.starts.push_back(output.starts.back() + level + 1);
+    }
+}
+
+void PatchTessellator::Tessellate(const GlyphGeometry &geometry, const TessellationSettings &settings,
+                                  Polylines &output)
+{
+    output.Clear();
+    TessellateStream(geometry.Lines(), geometry.LineVertices(), 1, settings, output);
+    TessellateStream(geometry.Quadratics(), geometry.QuadraticVertices(), 2, settings, output);
+    TessellateStream(geometry.Cubics(), geometry.CubicVertices(), 3, settings, output);
+}
+
+// --------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+// ==========================================================================
+// CPU Reference Tessellator
+//
+// Evaluates the patch streams of a GlyphGeometry the way the shaders do:
+//  - curve patches are split into isolines at the level tessControl.glsl
+//    picks (a fixed level, or the adaptive one from the on-screen control
+//    polygon), and each vertex is the Bernstein form tessEval.glsl uses at
+//    u = k / level, k = 0..level;
+//  - straight segments are drawn as they are, one 2-point polyline each.
+// Patches are in clip space, as the vertex shader outputs them when the
+// scene is not scrolling. The result can be written to and read from a
+// text file and compared against a reference written earlier by the same
+// code. That makes the check a regression snapshot: it catches changes to
+// the geometry or to this tessellator, but it does not capture what the
+// GPU's tessellation stage produces.
+// ==========================================================================
+#ifndef TESSELLATOR_H
+#define TESSELLATOR_H
+
+#include <string>
+#include <vector>
+
+#include "GlyphGeometry.h"
+
+// the tessellation uniforms of tessControl.glsl
+struct TessellationSettings
+{
+    bool    adaptive;
+    float   fixedLevel;         // level of every patch when not adaptive
+    float   viewportWidth;      // framebuffer size in pixels
+    float   viewportHeight;
+    float   pixelTolerance;
+    float   maxLevel;           // clamps both the fixed and adaptive levels
+
+    TessellationSettings()
+        : adaptive(true), fixedLevel(100.f), viewportWidth(1024.f), viewportHeight(1024.f),
+          pixelTolerance(0.25f), maxLevel(64.f)
+    {}
+};
+
+// a set of polylines stored back to back: polyline i is points
+// [starts[i], starts[i+1]) of the (x, y) array
+struct Polylines
+{
+    std::vector<float>          points;
+    std::vector<unsigned int>   starts;
+
+    Polylines() : starts(1, 0)
+    {}
+
+    void Clear()                    { points.clear(); starts.assign(1, 0); }
+    size_t Count() const            { return starts.size() - 1; }
+    size_t PointCount() const       { return points.size() / 2; }
+
+    // saves as text, one polyline per line ("count x0 y0 x1 y1 ..."), and
+    // loads such a file, returning false if it cannot be read
+    bool Write(const std::string &filename) const;
+    bool Read(const std::string &filename);
+
+    // true if both sets have the same shape and every coordinate is within
+    // [tolerance]; the largest difference is returned through maxError
+    static bool Compare(const Polylines &a, const Polylines &b, float tolerance,
+                        float *maxError = 0);
+};
+
+class PatchTessellator
+{
+public:
+    // isoline level tessControl.glsl gives a patch of the given degree
+    // (2 or 3), from its four control points
+    static float Level(const float *patch, int degree, const TessellationSettings &settings);
+
+    // point of a patch at parameter u, as tessEval.glsl computes it
+    static void Evaluate(const float *patch, int degree, float u, float &x, float &y);
+
+    // appends the polylines of a stream of 4-vertex curve patches, or of
+    // 2-vertex straight segments for degree 1
+    static void TessellateStream(const float *vertices, size_t count, int degree,
+                                 const TessellationSettings &settings, Polylines &output);
+
+    // tessellates the line, quadratic and cubic streams of a geometry, in
+    // that order, replacing the output's contents
+    static void Tessellate(const GlyphGeometry &geometry, const TessellationSettings &settings,
+                           Polylines &output);
+};
+
+// --------------------------------------------------------------------------
+#endif // TESSELLATOR_H
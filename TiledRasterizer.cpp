@@ -0,0 +1,182 @@
+// ==========================================================================
+// Tile-Binned Multithreaded Rasterizer
+//
+// See TiledRasterizer.h. A tile accumulates its edges in tile coordinates
+// with Rasterizer::AccumulateEdge, which moves the parts of an edge left of
+// the tile onto its left border; that is exactly the winding those parts
+// add to the tile, so an edge only has to be binned into the tiles its
+// clipped extent touches, plus the backdrop of the tiles to its right.
+// ==========================================================================
+
+#include "TiledRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+const int TiledRasterizer::TILE_SIZE;
+
+TiledRasterizer::TiledRasterizer(unsigned int threads)
+    : m_pool(threads), m_width(0), m_height(0), m_columns(0), m_rows(0),
+      m_tolerance(0.2f), m_resolved(0), m_binned(0)
+{
+    m_scratch.resize(m_pool.ThreadCount(),
+                     vector<float>(size_t(TILE_SIZE + 2) * TILE_SIZE, 0.f));
+}
+
+void TiledRasterizer::Begin(const Framebuffer &target)
+{
+    m_width = target.width;
+    m_height = target.height;
+    m_columns = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+    m_rows = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+
+    // the per-band and per-tile lists keep their capacity between frames
+    m_edges.clear();
+    m_bandEdges.resize(m_rows);
+    m_tileEdges.resize(size_t(m_columns) * m_rows);
+    m_backdrops.assign(size_t(m_columns) * m_rows * TILE_SIZE, 0.f);
+}
+
+void TiledRasterizer::AddStream(const float *vertices, size_t count, int degree, float width)
+{
+    Rasterizer::StreamEdges(vertices, count, degree, width, m_width, m_height, m_tolerance, m_edges);
+}
+
+void TiledRasterizer::Fill(const GlyphGeometry &geometry)
+{
+    FillStream(geometry.Lines(), geometry.LineVertices(), 1);
+    FillStream(geometry.Quadratics(), geometry.QuadraticVertices(), 2);
+    FillStream(geometry.Cubics(), geometry.CubicVertices(), 3);
+}
+
+void TiledRasterizer::Stroke(const GlyphGeometry &geometry, float width)
+{
+    StrokeStream(geometry.Lines(), geometry.LineVertices(), 1, width);
+    StrokeStream(geometry.Quadratics(), geometry.QuadraticVertices(), 2, width);
+    StrokeStream(geometry.Cubics(), geometry.CubicVertices(), 3, width);
+}
+
+// --------------------------------------------------------------------------
+
+void TiledRasterizer::BinBand(int band)
+{
+    float top = float(band * TILE_SIZE), bottom = top + TILE_SIZE;
+    float *backdrop = &m_backdrops[size_t(band) * m_columns * TILE_SIZE];
+    fill(backdrop, backdrop + size_t(m_columns) * TILE_SIZE, 0.f);
+    for (int c = 0; c < m_columns; ++c)
+        m_tileEdges[size_t(band) * m_columns + c].clear();
+
+    const vector<unsigned int> &edges = m_bandEdges[band];
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        // the part of the edge within the band, keeping its direction
+        const RasterEdge &edge = m_edges[edges[i]];
+        float direction = edge.y1 > edge.y0 ? 1.f : -1.f;
+        float x0 = edge.x0, y0 = edge.y0, x1 = edge.x1, y1 = edge.y1;
+        if (direction < 0.f) {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+        float dxdy = (x1 - x0) / (y1 - y0);
+        float ya = max(y0, top), yb = min(y1, bottom);
+        if (ya >= yb) continue;
+        float xa = x0 + (ya - y0) * dxdy, xb = x0 + (yb - y0) * dxdy;
+
+        float minX = min(xa, xb), maxX = max(xa, xb);
+        if (minX >= float(m_width)) continue;
+
+        int first = max(0, int(floor(minX / TILE_SIZE)));
+        int last = maxX < 0.f ? -1 : min(m_columns - 1, int(floor(maxX / TILE_SIZE)));
+        RasterEdge piece = { xa, ya, xb, yb };
+        if (direction < 0.f) piece = { xb, yb, xa, ya };
+        for (int c = first; c <= last; ++c)
+            m_tileEdges[size_t(band) * m_columns + c].push_back(piece);
+
+        // every tile right of the last one touched sees the edge's full
+        // winding on each scanline it crosses
+        if (last + 1 >= m_columns) continue;
+        float *delta = backdrop + size_t(last + 1) * TILE_SIZE;
+        for (int row = int(floor(ya)); row < int(ceil(yb)); ++row) {
+            float dy = min(float(row + 1), yb) - max(float(row), ya);
+            delta[row - band * TILE_SIZE] += dy * direction;
+        }
+    }
+
+    // deltas to totals, from left to right
+    for (int c = 1; c < m_columns; ++c)
+        for (int row = 0; row < TILE_SIZE; ++row)
+            backdrop[c * TILE_SIZE + row] += backdrop[(c - 1) * TILE_SIZE + row];
+}
+
+void TiledRasterizer::RasterizeTile(int tile, unsigned int worker, Framebuffer &target,
+                                    const float colour[4])
+{
+    const vector<RasterEdge> &edges = m_tileEdges[tile];
+    const float *backdrop = &m_backdrops[size_t(tile) * TILE_SIZE];
+
+    int left = (tile % m_columns) * TILE_SIZE, top = (tile / m_columns) * TILE_SIZE;
+    int width = min(TILE_SIZE, m_width - left), height = min(TILE_SIZE, m_height - top);
+
+    bool empty = edges.empty();
+    for (int row = 0; empty && row < height; ++row)
+        empty = fabs(backdrop[row]) < 1e-6f;
+    if (empty) return;
+
+    const int stride = TILE_SIZE + 2;
+    float *coverage = &m_scratch[worker][0];
+    for (int row = 0; row < height; ++row)
+        coverage[row * stride] = backdrop[row];
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const RasterEdge &edge = edges[i];
+        Rasterizer::AccumulateEdge(coverage, width, height, stride, edge.x0 - left,
+                                   edge.y0 - top, edge.x1 - left, edge.y1 - top);
+    }
+
+    // resolving clears the rows again, ready for this worker's next tile
+    for (int row = 0; row < height; ++row)
+        Rasterizer::ResolveRow(coverage + row * stride, width, stride,
+                               &target.pixels[(size_t(top + row) * m_width + left) * 4], colour);
+}
+
+void TiledRasterizer::Resolve(Framebuffer &target, float r, float g, float b, float a)
+{
+    if (target.width != m_width || target.height != m_height) {
+        cout << "TiledRasterizer ERROR: framebuffer size changed since Begin." << endl;
+        return;
+    }
+
+    // file each edge under the bands it crosses
+    for (int band = 0; band < m_rows; ++band)
+        m_bandEdges[band].clear();
+    for (size_t i = 0; i < m_edges.size(); ++i)
+    {
+        const RasterEdge &edge = m_edges[i];
+        if (edge.y0 == edge.y1) continue;
+        float minY = min(edge.y0, edge.y1), maxY = max(edge.y0, edge.y1);
+        if (maxY <= 0.f || minY >= float(m_height)) continue;
+        int first = max(0, int(floor(minY / TILE_SIZE)));
+        int last = min(m_rows - 1, int(floor(maxY / TILE_SIZE)));
+        for (int band = first; band <= last; ++band)
+            m_bandEdges[band].push_back(i);
+    }
+
+    m_pool.Run(m_rows, [&](size_t band, unsigned int) { BinBand(int(band)); });
+
+    m_binned = 0;
+    for (size_t t = 0; t < m_tileEdges.size(); ++t)
+        m_binned += m_tileEdges[t].size();
+
+    float colour[4] = { r, g, b, a };
+    m_pool.Run(m_tileEdges.size(), [&](size_t tile, unsigned int worker) {
+        RasterizeTile(int(tile), worker, target, colour);
+    });
+
+    m_resolved = m_edges.size();
+    m_edges.clear();
+}
+
+// --------------------------------------------------------------------------
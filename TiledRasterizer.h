@@ -0,0 +1,90 @@
+// ==========================================================================
+// Tile-Binned Multithreaded Rasterizer
+//
+// Renders the same streams as Rasterizer, with the same coverage result,
+// but splits the framebuffer into square tiles that are rasterized in
+// parallel on a WorkStealingPool, for large canvases such as posters and
+// specimen sheets. Resolve runs in three steps:
+//  1. every flattened edge is filed under the bands (rows of tiles) its
+//     vertical extent crosses;
+//  2. in parallel per band, each edge is clipped to the band and binned
+//     into the tiles its horizontal extent touches there; the winding it
+//     adds to tiles further right is recorded as a per-scanline backdrop,
+//     so such tiles never see the edge itself;
+//  3. in parallel per tile, the tile's backdrop and edges are accumulated
+//     into a small per-thread coverage buffer and composited into the
+//     tile's pixels. Tiles with no edges and no backdrop are skipped.
+// ==========================================================================
+#ifndef TILEDRASTERIZER_H
+#define TILEDRASTERIZER_H
+
+#include "Rasterizer.h"
+#include "WorkStealingPool.h"
+
+class TiledRasterizer
+{
+    // edges added since the last Resolve, in pixels with +y down
+    std::vector<RasterEdge>     m_edges;
+
+    // edge indices per band, band-clipped edges per tile, and the winding
+    // entering each tile from the left, TILE_SIZE scanlines per tile
+    std::vector<std::vector<unsigned int> > m_bandEdges;
+    std::vector<std::vector<RasterEdge> >   m_tileEdges;
+    std::vector<float>                      m_backdrops;
+
+    // coverage scratch of each worker
+    std::vector<std::vector<float> >        m_scratch;
+
+    WorkStealingPool    m_pool;
+    int                 m_width;
+    int                 m_height;
+    int                 m_columns;      // tiles across and down
+    int                 m_rows;
+    float               m_tolerance;
+
+    // edges resolved, and edge pieces binned into tiles, by the last Resolve
+    size_t              m_resolved;
+    size_t              m_binned;
+
+    void AddStream(const float *vertices, size_t count, int degree, float width);
+
+    // steps 2 and 3 above for one band and one tile
+    void BinBand(int band);
+    void RasterizeTile(int tile, unsigned int worker, Framebuffer &target, const float colour[4]);
+
+public:
+    static const int TILE_SIZE = 64;
+
+    // starts [threads] workers, or one per hardware thread if zero
+    explicit TiledRasterizer(unsigned int threads = 0);
+
+    unsigned int ThreadCount() const    { return m_pool.ThreadCount(); }
+
+    // sizes the tile grid for a target and drops any pending edges
+    void Begin(const Framebuffer &target);
+
+    // flattening tolerance in pixels (default 0.2)
+    void SetTolerance(float pixels)     { m_tolerance = pixels; }
+    float Tolerance() const             { return m_tolerance; }
+
+    // adds streams or geometry, as for Rasterizer
+    void FillStream(const float *vertices, size_t count, int degree)
+    { AddStream(vertices, count, degree, 0.f); }
+    void StrokeStream(const float *vertices, size_t count, int degree, float width)
+    { AddStream(vertices, count, degree, width); }
+    void Fill(const GlyphGeometry &geometry);
+    void Stroke(const GlyphGeometry &geometry, float width);
+
+    // bins and rasterizes the pending edges, composites them over the target
+    // in the given colour and drops them for the next pass
+    void Resolve(Framebuffer &target, float r, float g, float b, float a = 1.f);
+
+    // statistics of the last Resolve
+    size_t EdgeCount() const            { return m_resolved; }
+    size_t BinnedCount() const          { return m_binned; }
+    size_t TileCount() const            { return size_t(m_columns) * m_rows; }
+    unsigned long Steals() const        { return m_pool.Steals(); }
+};
+
+// --------------------------------------------------------------------------
+#endif // TILEDRASTERIZER_H
@@ -0,0 +1,114 @@
+// ==========================================================================
+// Work-Stealing Thread Pool
+//
+// See WorkStealingPool.h. A batch never adds tasks once it has started, so
+// a worker is done as soon as its own queue and every other queue are empty.
+// ==========================================================================
+
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+// --------------------------------------------------------------------------
+
+WorkStealingPool::WorkStealingPool(unsigned int threads)
+    : m_task(0), m_generation(0), m_busy(0), m_quit(false), m_steals(0)
+{
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    for (unsigned int i = 0; i < threads; ++i)
+        m_queues.push_back(unique_ptr<Queue>(new Queue));
+    for (unsigned int i = 0; i < threads; ++i)
+        m_threads.push_back(thread(&WorkStealingPool::WorkerLoop, this, i));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+}
+
+// --------------------------------------------------------------------------
+
+bool WorkStealingPool::Pop(unsigned int worker, size_t &task)
+{
+    Queue &queue = *m_queues[worker];
+    lock_guard<mutex> lock(queue.lock);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::Steal(unsigned int worker, size_t &task)
+{
+    // victims are tried starting from the next worker, so thieves spread out
+    for (size_t i = 1; i < m_queues.size(); ++i)
+    {
+        Queue &queue = *m_queues[(worker + i) % m_queues.size()];
+        lock_guard<mutex> lock(queue.lock);
+        if (queue.tasks.empty()) continue;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        ++m_steals;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerLoop(unsigned int worker)
+{
+    unsigned long seen = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m_lock);
+            m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+            if (m_quit) return;
+            seen = m_generation;
+        }
+
+        size_t task;
+        while (Pop(worker, task) || Steal(worker, task))
+            (*m_task)(task, worker);
+
+        {
+            lock_guard<mutex> lock(m_lock);
+            if (--m_busy == 0) m_finished.notify_one();
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+
+void WorkStealingPool::Run(size_t count, const Task &task)
+{
+    if (count == 0) return;
+
+    // workers are idle between batches, so their queues can be filled here
+    size_t workers = m_queues.size();
+    for (size_t w = 0; w < workers; ++w)
+    {
+        deque<size_t> &tasks = m_queues[w]->tasks;
+        for (size_t i = w * count / workers; i < (w + 1) * count / workers; ++i)
+            tasks.push_back(i);
+    }
+
+    unique_lock<mutex> lock(m_lock);
+    m_task = &task;
+    m_busy = workers;
+    ++m_generation;
+    m_wake.notify_all();
+
+    m_finished.wait(lock, [&] { return m_busy == 0; });
+    m_task = 0;
+}
+
+// --------------------------------------------------------------------------
@@ -0,0 +1,75 @@
+// ==========================================================================
+// Work-Stealing Thread Pool
+//
+// Runs batches of independent tasks, numbered 0..count-1, on a fixed set of
+// worker threads. Each batch is split into one contiguous block per worker,
+// so neighbouring tasks (e.g. adjacent screen tiles) tend to run on the same
+// thread; a worker that runs out of its own tasks steals from the far end
+// of another worker's queue, which evens out batches whose tasks differ
+// widely in cost. Run returns once every task of the batch is done.
+// ==========================================================================
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+    // a task receives its index and the index of the worker running it,
+    // which callers can use to pick per-thread scratch storage
+    typedef std::function<void(size_t task, unsigned int worker)> Task;
+
+private:
+    struct Queue
+    {
+        std::mutex          lock;
+        std::deque<size_t>  tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue> >    m_queues;   // one per worker
+    std::vector<std::thread>                m_threads;
+
+    const Task             *m_task;         // the batch being run
+
+    std::mutex              m_lock;
+    std::condition_variable m_wake;         // signals a new batch or shutdown
+    std::condition_variable m_finished;     // signals the last worker is done
+    unsigned long           m_generation;   // incremented for every batch
+    unsigned int            m_busy;         // workers still on this batch
+    bool                    m_quit;
+
+    std::atomic<unsigned long> m_steals;
+
+    // takes the next task from the worker's own queue, or from another's
+    bool Pop(unsigned int worker, size_t &task);
+    bool Steal(unsigned int worker, size_t &task);
+
+    void WorkerLoop(unsigned int worker);
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+public:
+    // starts [threads] workers, or one per hardware thread if zero
+    explicit WorkStealingPool(unsigned int threads = 0);
+    ~WorkStealingPool();
+
+    unsigned int ThreadCount() const    { return m_threads.size(); }
+
+    // runs task(i, worker) for every i in [0, count) and waits for all of them
+    void Run(size_t count, const Task &task);
+
+    // tasks taken from another worker's queue since the pool started
+    unsigned long Steals() const        { return m_steals; }
+};
+
+// --------------------------------------------------------------------------
+#endif // WORKSTEALINGPOOL_H
@@ -16,6 +16,9 @@
 #include <string>
 #include <iterator>
 #include "GlyphExtractor.h"
+#include "GlyphBank.h"
+#include "GlyphGeometry.h"
+#include "GlyphMesh.h"
 
 // Specify that we want the OpenGL core profile before including GLFW headers
 #ifndef LAB_LINUX
@@ -26,11 +29,6 @@
 #endif
 #include <GLFW/glfw3.h>
 
-//STB
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
 using namespace std;
 
 int bezierType = 0;
@@ -58,11 +56,13 @@ struct MyShader
 	GLuint  program;
 
 	// initialize shader and program names to zero (OpenGL reserved value)
-	MyShader() : vertex(0), fragment(0), program(0)
+	MyShader() : vertex(0), TCS(0), TES(0), fragment(0), program(0)
 	{}
 };
 
 MyShader shader;
+MyShader lineShader;
+MyShader curveShader;
 
 // load, compile, and link shaders, returning true if successful
 bool InitializeShaders(MyShader *shader)
@@ -87,6 +87,35 @@ bool InitializeShaders(MyShader *shader)
 	return !CheckGLErrors();
 }
 
+// load, compile, and link the untessellated program for straight line
+// segments, returning true if successful
+bool InitializeLineShader(MyShader *shader)
+{
+	string vertexSource = LoadSource("lineVertex.glsl");
+	string fragmentSource = LoadSource("fragment.glsl");
+	if (vertexSource.empty() || fragmentSource.empty()) return false;
+
+	shader->vertex = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	shader->fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	shader->program = LinkProgram(shader->vertex, 0, 0, shader->fragment);
+
+	return !CheckGLErrors();
+}
+
+// load, compile, and link the curve fill program (see CurveFill.h)
+bool InitializeCurveShader(MyShader *shader)
+{
+	string vertexSource = LoadSource("curveVertex.glsl");
+	string fragmentSource = LoadSource("curveFragment.glsl");
+	if (vertexSource.empty() || fragmentSource.empty()) return false;
+
+	shader->vertex = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	shader->fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	shader->program = LinkProgram(shader->vertex, 0, 0, shader->fragment);
+
+	return !CheckGLErrors();
+}
+
 // deallocate shader-related objects
 void DestroyShaders(MyShader *shader)
 {
@@ -102,68 +131,186 @@ void DestroyShaders(MyShader *shader)
 // --------------------------------------------------------------------------
 // Functions to set up OpenGL buffers for storing geometry data
 
+// vertex formats of the vertex buffer: bare positions, or positions
+// interleaved with a packed RGBA8 colour
+enum MyVertexLayout { LAYOUT_POSITION, LAYOUT_POSITION_COLOUR };
+
+struct MyColouredVertex
+{
+	GLfloat x, y;
+	GLubyte colour[4];
+};
+
 struct MyGeometry
 {
 	// OpenGL names for array buffer objects, vertex array object
 	GLuint  vertexBuffer;
 	GLuint  textureBuffer;
-	GLuint  colourBuffer;
 	GLuint  vertexArray;
 	GLsizei elementCount;
 
+	// format of the vertex buffer, and the colour of every vertex when it
+	// holds positions only
+	MyVertexLayout layout;
+	GLfloat constantColour[3];
+
+	// per-instance transforms and the draws over them, for instanced glyphs
+	GLuint  instanceBuffer;
+	bool    instanced;
+	vector<GlyphDraw> draws;
+
+	// allocated size of each buffer in bytes; the buffers and vertex array
+	// are created once and reused by every later update of this geometry
+	GLsizeiptr vertexCapacity;
+	GLsizeiptr instanceCapacity;
+
 	// initialize object names to zero (OpenGL reserved value)
-	MyGeometry() : vertexBuffer(0), colourBuffer(0), vertexArray(0), elementCount(0)
-	{}
+	MyGeometry() : vertexBuffer(0), vertexArray(0), elementCount(0), layout(LAYOUT_POSITION),
+		instanceBuffer(0), instanced(false), vertexCapacity(0), instanceCapacity(0)
+	{
+		constantColour[0] = constantColour[1] = constantColour[2] = 1.f;
+	}
 };
 
 MyGeometry geomPoints;
 MyGeometry geomLines;
 MyGeometry geomQuad;
 MyGeometry geomCubic;
+MyGeometry geomFill;		// filled text, as triangle meshes
+// filled text, as curve fill meshes: interior, quadratic curve and cubic
+// curve triangles
+MyGeometry geomCurveSolids;
+MyGeometry geomCurveQuadratics;
+MyGeometry geomCurveCubics;
+
+// statistics of the buffers owned by the geometry slots
+struct MyBufferPoolStats
+{
+	unsigned long buffersCreated;
+	unsigned long vertexArraysCreated;
+	unsigned long reallocations;	// buffer storage grown to fit an update
+	unsigned long updates;			// updates that reused existing storage
+	GLsizeiptr    bytesAllocated;	// current total buffer storage
+	GLsizeiptr    peakBytes;
+
+	MyBufferPoolStats() : buffersCreated(0), vertexArraysCreated(0), reallocations(0), updates(0),
+		bytesAllocated(0), peakBytes(0)
+	{}
+};
 
-// create buffers and fill with geometry data, returning true if successful
-bool InitializeGeometry(MyGeometry *geometry, GLfloat *points, GLfloat *cols, int elemCount, float scale, float transform){
-	GLfloat vertices[elemCount][2];
-	GLfloat colours[elemCount][3];
-	
-	for(int i = 0; i < elemCount; i++){
-		vertices[i][0] = (points[2*i] + transform) / scale;
-		vertices[i][1] = (points[2*i + 1] + transform) / scale;
-		
-		colours[i][0] = cols[3*i];
-		colours[i][1] = cols[3*i + 1];
-		colours[i][2] = cols[3*i + 2];
-	}
-	geometry->elementCount = elemCount; 
+MyBufferPoolStats bufferPool;
 
-	// these vertex attribute indices correspond to those specified for the
-	// input variables in the vertex shader
-	const GLuint VERTEX_INDEX = 0;
-	const GLuint COLOUR_INDEX = 1;
+void PrintBufferPoolStats(){
+	cout << "Buffer pool: " << bufferPool.buffersCreated << " buffers and "
+		<< bufferPool.vertexArraysCreated << " vertex arrays created, "
+		<< bufferPool.reallocations << " reallocations, " << bufferPool.updates << " reused updates, "
+		<< bufferPool.bytesAllocated << " bytes allocated (peak " << bufferPool.peakBytes << ")" << endl;
+}
 
-	// create an array buffer object for storing our vertices
-	glGenBuffers(1, &geometry->vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+// fills a pooled array buffer with [bytes] of data, creating it on first
+// use; storage grows geometrically when an update does not fit, and is
+// otherwise orphaned and refilled in place so the draw in flight keeps the
+// old contents
+void UploadBuffer(GLuint *buffer, GLsizeiptr *capacity, const GLvoid *data, GLsizeiptr bytes){
+	if (!*buffer) {
+		glGenBuffers(1, buffer);
+		bufferPool.buffersCreated++;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, *buffer);
+
+	if (bytes > *capacity) {
+		GLsizeiptr grown = max(bytes, *capacity * 2);
+		bufferPool.bytesAllocated += grown - *capacity;
+		bufferPool.peakBytes = max(bufferPool.peakBytes, bufferPool.bytesAllocated);
+		bufferPool.reallocations++;
+		*capacity = grown;
+	}
+	else
+		bufferPool.updates++;
 
-	// create another one for storing our colours
-	glGenBuffers(1, &geometry->colourBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->colourBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(colours), colours, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, *capacity, 0, GL_DYNAMIC_DRAW);
+	if (bytes > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+}
 
-	// create a vertex array object encapsulating all our vertex attributes
-	glGenVertexArrays(1, &geometry->vertexArray);
+// creates the vertex array of a geometry slot on first use and binds it
+void BindGeometryArray(MyGeometry *geometry){
+	if (!geometry->vertexArray) {
+		glGenVertexArrays(1, &geometry->vertexArray);
+		bufferPool.vertexArraysCreated++;
+	}
 	glBindVertexArray(geometry->vertexArray);
+}
+
+// these vertex attribute indices correspond to those specified for the
+// input variables in the vertex shader
+const GLuint VERTEX_INDEX = 0;
+const GLuint COLOUR_INDEX = 1;
+const GLuint INSTANCE_INDEX = 2;
+const GLuint CURVE_INDEX = 3;
+
+// staging arrays for InitializeGeometry, kept between calls so that large
+// scenes neither overflow the stack nor reallocate on every build
+vector<GLfloat> stagedPositions;
+vector<MyColouredVertex> stagedVertices;
+
+// converts a colour component in [0, 1] to a normalized byte
+GLubyte PackColour(GLfloat c){
+	return GLubyte(min(max(c, 0.f), 1.f) * 255.f + 0.5f);
+}
+
+// fill the geometry's buffers with vertex data, returning true if
+// successful; with a colour array the positions are interleaved with RGBA8
+// colours, and without one only positions are uploaded and every vertex
+// takes the geometry's constant colour (white)
+bool InitializeGeometry(MyGeometry *geometry, const GLfloat *points, const GLfloat *cols, int elemCount, float scale, float transform){
+	geometry->elementCount = elemCount; 
+	geometry->layout = cols ? LAYOUT_POSITION_COLOUR : LAYOUT_POSITION;
+	geometry->constantColour[0] = geometry->constantColour[1] = geometry->constantColour[2] = 1.f;
+	geometry->instanced = false;
+	geometry->draws.clear();
+
+	GLsizei stride;
+	if (cols) {
+		if (stagedVertices.size() < size_t(elemCount))
+			stagedVertices.resize(max(stagedVertices.size() * 2, size_t(elemCount)));
+		for(int i = 0; i < elemCount; i++){
+			MyColouredVertex &vertex = stagedVertices[i];
+			vertex.x = (points[2*i] + transform) / scale;
+			vertex.y = (points[2*i + 1] + transform) / scale;
+			vertex.colour[0] = PackColour(cols[3*i]);
+			vertex.colour[1] = PackColour(cols[3*i + 1]);
+			vertex.colour[2] = PackColour(cols[3*i + 2]);
+			vertex.colour[3] = 255;
+		}
+		stride = sizeof(MyColouredVertex);
+		UploadBuffer(&geometry->vertexBuffer, &geometry->vertexCapacity, stagedVertices.data(), elemCount * stride);
+	}
+	else {
+		if (stagedPositions.size() < size_t(elemCount) * 2)
+			stagedPositions.resize(max(stagedPositions.size() * 2, size_t(elemCount) * 2));
+		for(int i = 0; i < elemCount * 2; i++)
+			stagedPositions[i] = (points[i] + transform) / scale;
+		stride = 2 * sizeof(GLfloat);
+		UploadBuffer(&geometry->vertexBuffer, &geometry->vertexCapacity, stagedPositions.data(), elemCount * stride);
+	}
 
-	// associate the position array with the vertex array object
+	// point the vertex array object at the pooled vertex buffer
+	BindGeometryArray(geometry);
 	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
-	glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, stride, 0);
 	glEnableVertexAttribArray(VERTEX_INDEX);
 
-	// assocaite the colour array with the vertex array object
-	glBindBuffer(GL_ARRAY_BUFFER, geometry->colourBuffer);
-	glVertexAttribPointer(COLOUR_INDEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(COLOUR_INDEX);
+	// the colour, if any, follows the position in each vertex
+	if (cols) {
+		glVertexAttribPointer(COLOUR_INDEX, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (const GLvoid *)(2 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(COLOUR_INDEX);
+	}
+	else
+		glDisableVertexAttribArray(COLOUR_INDEX);
+
+	// drawn without instancing, even if it held instanced glyphs before
+	glDisableVertexAttribArray(INSTANCE_INDEX);
 
 	// unbind our buffers, resetting to default state
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -173,6 +320,54 @@ bool InitializeGeometry(MyGeometry *geometry, GLfloat *points, GLfloat *cols, in
 	return !CheckGLErrors();
 }
 
+// fill the geometry's buffers with one stream of instanced glyph geometry:
+// each distinct outline's patches once, plus one transform per character
+bool InitializeInstancedGeometry(MyGeometry *geometry, InstancedGlyphGeometry &glyphs, InstancedGlyphGeometry::Stream stream){
+	geometry->elementCount = glyphs.Vertices(stream);
+	geometry->layout = LAYOUT_POSITION;
+	geometry->constantColour[0] = geometry->constantColour[1] = geometry->constantColour[2] = 1.f;
+	geometry->instanced = true;
+	geometry->draws = glyphs.Draws(stream);
+
+	// outline patches in EM units, and the per-instance (xTrans, yTrans,
+	// scale) grouped by outline
+	int floats = InstancedGlyphGeometry::VertexFloats(stream);
+	UploadBuffer(&geometry->vertexBuffer, &geometry->vertexCapacity, glyphs.Patches(stream),
+		glyphs.Vertices(stream) * floats * sizeof(GLfloat));
+	UploadBuffer(&geometry->instanceBuffer, &geometry->instanceCapacity, glyphs.Instances(),
+		glyphs.InstanceCount() * sizeof(GlyphInstance));
+
+	BindGeometryArray(geometry);
+
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+	glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, floats * sizeof(GLfloat), 0);
+	glEnableVertexAttribArray(VERTEX_INDEX);
+
+	// cubic curve fill vertices follow their position with (k, l, m)
+	if (stream == InstancedGlyphGeometry::CURVE_CUBICS) {
+		glVertexAttribPointer(CURVE_INDEX, 3, GL_FLOAT, GL_FALSE, floats * sizeof(GLfloat),
+			(const GLvoid *)(2 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(CURVE_INDEX);
+	}
+	else
+		glDisableVertexAttribArray(CURVE_INDEX);
+
+	// instanced glyphs hold positions only and take the constant colour
+	glDisableVertexAttribArray(COLOUR_INDEX);
+
+	// the instance pointer is re-pointed at each draw's first instance
+	// when rendering, since there is no base-instance draw in OpenGL 4.1
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->instanceBuffer);
+	glVertexAttribPointer(INSTANCE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), 0);
+	glVertexAttribDivisor(INSTANCE_INDEX, 1);
+	glEnableVertexAttribArray(INSTANCE_INDEX);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	return !CheckGLErrors();
+}
+
 // deallocate geometry-related objects
 void DestroyGeometry(MyGeometry *geometry)
 {
@@ -180,7 +375,9 @@ void DestroyGeometry(MyGeometry *geometry)
 	glBindVertexArray(0);
 	glDeleteVertexArrays(1, &geometry->vertexArray);
 	glDeleteBuffers(1, &geometry->vertexBuffer);
-	glDeleteBuffers(1, &geometry->colourBuffer);
+	glDeleteBuffers(1, &geometry->instanceBuffer);
+	bufferPool.bytesAllocated -= geometry->vertexCapacity + geometry->instanceCapacity;
+	*geometry = MyGeometry();
 }
 
 bool printPoints = false;
@@ -188,17 +385,121 @@ bool printLinear = false;
 bool printQuad = false;
 bool printCubic = false;
 
-void renderArray(MyGeometry *geometry, MyShader *shader){
+bool scroll = false;
+bool awesome = false;
+bool text = false;
+
+// how text is filled: not at all, with triangulated meshes, or with
+// resolution-independent curve fill; F cycles through them
+enum MyFillMode { FILL_NONE, FILL_MESH, FILL_CURVES, FILL_MODE_COUNT };
+int fillMode = FILL_NONE;
+float scrollFactor = 0.f;
+float scrollSpeed = 3.f;
+float scrollBound = 0.f;
+
+// tessellation level settings, and the number of primitives (line pieces)
+// the patch draws of the last measured frame generated, counted with a
+// GL_PRIMITIVES_GENERATED query around those draws only
+bool adaptiveTessellation = true;
+float pixelTolerance = 0.25f;
+GLuint primitiveQuery = 0;
+bool primitiveQueryPending = false;
+GLuint primitivesGenerated = 0;
+
+void PrintTessellationStats(){
+	if (adaptiveTessellation)
+		cout << "Tessellation: adaptive, " << pixelTolerance << " pixel tolerance, ";
+	else
+		cout << "Tessellation: fixed level 100 (clamped to 64), ";
+	cout << primitivesGenerated << " tessellated primitives per frame" << endl;
+}
+
+void renderArray(MyGeometry *geometry, MyShader *shader, GLenum mode = GL_PATCHES){
 	glUseProgram(shader->program);
 	GLint loc = glGetUniformLocation(shader->program, "bezierType");
 	if (loc != -1)
 		glUniform1i(loc, bezierType);
+	// geometry without a colour array is drawn in its constant colour,
+	// supplied as the generic value of the colour attribute
+	if (geometry->layout == LAYOUT_POSITION)
+		glVertexAttrib3fv(COLOUR_INDEX, geometry->constantColour);
 	glBindVertexArray(geometry->vertexArray);
-	glDrawArrays(GL_PATCHES, 0, geometry->elementCount);
+	if (geometry->instanced) {
+		// one instanced draw per distinct glyph in this stream
+		glBindBuffer(GL_ARRAY_BUFFER, geometry->instanceBuffer);
+		for (size_t i = 0; i < geometry->draws.size(); i++){
+			const GlyphDraw &draw = geometry->draws[i];
+			glVertexAttribPointer(INSTANCE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance),
+				(const GLvoid *)(draw.firstInstance * sizeof(GlyphInstance)));
+			glDrawArraysInstanced(mode, draw.firstVertex, draw.vertexCount, draw.instanceCount);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else
+		glDrawArrays(mode, 0, geometry->elementCount);
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
 
+// draws 2-vertex straight segments as GL_LINES (or filled glyph meshes as
+// GL_TRIANGLES) with the line program, which shares the scene state of the
+// tessellated program
+void renderLines(MyGeometry *geometry, MyShader *shader, GLenum mode = GL_LINES){
+	glUseProgram(shader->program);
+	GLint loc = glGetUniformLocation(shader->program, "text");
+	if (loc != -1)
+		glUniform1i(loc, text);
+	loc = glGetUniformLocation(shader->program, "awesome");
+	if (loc != -1)
+		glUniform1i(loc, awesome);
+	loc = glGetUniformLocation(shader->program, "scroll");
+	if (loc != -1)
+		glUniform1i(loc, scroll);
+	loc = glGetUniformLocation(shader->program, "scrollFactor");
+	if (loc != -1)
+		glUniform1f(loc, scrollFactor);
+	renderArray(geometry, shader, mode);
+}
+
+// draws the three streams of the curve fill meshes: interior triangles
+// take the constant coordinates (-1, 0, 0) as the generic value of the
+// curve attribute, quadratic curve triangles the canonical ones of their
+// corners from the shader, and cubic curve triangles their own
+void renderCurveStreams(MyShader *shader){
+	glVertexAttrib3fv(CURVE_INDEX, CurveFill::SOLID_COORDINATES);
+	renderLines(&geomCurveSolids, shader, GL_TRIANGLES);
+
+	glUseProgram(shader->program);
+	GLint loc = glGetUniformLocation(shader->program, "quadratic");
+	if (loc != -1)
+		glUniform1i(loc, true);
+	renderLines(&geomCurveQuadratics, shader, GL_TRIANGLES);
+
+	glUseProgram(shader->program);
+	if (loc != -1)
+		glUniform1i(loc, false);
+	renderLines(&geomCurveCubics, shader, GL_TRIANGLES);
+}
+
+// fills curve meshes by stencil, then cover: the first pass counts the
+// winding number of every pixel in the stencil buffer, adding or removing
+// one per triangle by its orientation, and the second paints the pixels
+// left with a nonzero count and resets them
+void renderCurves(MyShader *shader){
+	glEnable(GL_STENCIL_TEST);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glStencilFunc(GL_ALWAYS, 0, 0xFF);
+	glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+	glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+	renderCurveStreams(shader);
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+	renderCurveStreams(shader);
+	glDisable(GL_STENCIL_TEST);
+}
+
 // --------------------------------------------------------------------------
 // Rendering function that draws our scene to the frame buffer
 
@@ -206,16 +507,28 @@ void RenderScene(MyShader *shader)
 {
 	// clear screen to a dark grey colour
 	glClearColor(0.f, 0.f, 0.f, 0.f);
-	glClear(GL_COLOR_BUFFER_BIT);
+	glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 	// bind our shader program and the vertex array object containing our
 	// scene geometry, then tell OpenGL to draw our geometry
 	// reset state to default (no shader or geometry bound)
 	
+	if(fillMode == FILL_MESH && text) {
+		bezierType = 1;
+		renderLines(&geomFill, &lineShader, GL_TRIANGLES);
+	}
+	if(fillMode == FILL_CURVES && text)
+		renderCurves(&curveShader);
 	if(printLinear) {
 		bezierType = 1;
-		renderArray(&geomLines, shader);
+		renderLines(&geomLines, &lineShader);
 	}
+
+	// count the primitives generated by the tessellated patch draws alone,
+	// unless the previous count has not arrived yet
+	bool measure = !primitiveQueryPending;
+	if (measure)
+		glBeginQuery(GL_PRIMITIVES_GENERATED, primitiveQuery);
 	if(printQuad) {
 		bezierType = 2;
 		renderArray(&geomQuad, shader);
@@ -228,6 +541,10 @@ void RenderScene(MyShader *shader)
 		bezierType = 0;
 		renderArray(&geomPoints, shader);
 	}
+	if (measure) {
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+		primitiveQueryPending = true;
+	}
 	glUseProgram(0);
 
 	// check for an report any OpenGL errors
@@ -238,67 +555,46 @@ void RenderScene(MyShader *shader)
 // GLFW callback functions
 
 GlyphExtractor extractor;
-MyGlyph glyph;
-MyContour contour;
-MySegment segment;
-
-bool scroll = false;
-bool awesome = false;
-bool text = false;
-float scrollFactor = 0.f;
-float scrollSpeed = 3.f;
-float scrollBound = 0.f;
-
-int lineCount = 0;
-int quadraticCount = 0;
-int cubicCount = 0;
+MyGlyphRun run;
 
 string fox = "The Quick Brown Fox Jumps Over the Lazy Dog.";
 string name = "SUSANT";
 
-void glyphCount() {
-	for (unsigned cont = 0; cont < glyph.contours.size(); cont++){
-		contour = glyph.contours[cont];
-		for (unsigned seg = 0; seg < contour.size(); seg++){
-			segment = contour[seg];
-			if (segment.degree == 1)
-				lineCount += 8;
-			else if (segment.degree == 2)
-				quadraticCount += 8;
-			else if (segment.degree == 3)
-				cubicCount += 8;
-		}
-	}
+// distinct outlines and per-character instances of the text scenes,
+// rebuilt in place for every scene, and the filled meshes of recently seen
+// outlines, kept across scenes within the cache's budget
+InstancedGlyphGeometry textGeometry;
+GlyphMeshCache meshCache;
+
+// has the text build the fill meshes of the current fill mode only, so a
+// scene rebuild with fill off triangulates and builds no curve fill
+void ConfigureTextFill(InstancedGlyphGeometry &text){
+	// filled meshes are flattened to 1/1024 EM, below a pixel at any scene's scale
+	text.SetMeshCache(fillMode == FILL_MESH ? &meshCache : 0, 1.f / 1024.f);
+	text.SetCurveFill(fillMode == FILL_CURVES);
 }
 
-void glyphToGeom(GLfloat *verLines, GLfloat *verQuad, GLfloat *verCub, float scale, float xTrans, float yTrans){
-	for (unsigned cont = 0; cont < glyph.contours.size(); cont++){
-		contour = glyph.contours[cont];
-		for (unsigned seg = 0; seg < contour.size(); seg++){
-			segment = contour[seg];
-			if (segment.degree == 1){
-				verLines[lineCount] = (segment.x[0] + xTrans) * scale; verLines[lineCount + 1] = (segment.y[0] + yTrans) * scale;
-				verLines[lineCount + 2] = (segment.x[1] + xTrans) * scale; verLines[lineCount + 3] = (segment.y[1] + yTrans) * scale;
-				verLines[lineCount + 4] = (0.f + xTrans) * scale; verLines[lineCount + 5] = (0.f + yTrans) * scale;
-				verLines[lineCount + 6] = (0.f + xTrans) * scale; verLines[lineCount + 7] = (0.f + yTrans) * scale;
-				lineCount += 8;
-			}
-			else if (segment.degree == 2){
-				verQuad[quadraticCount] = (segment.x[0] + xTrans) * scale; verQuad[quadraticCount + 1] = (segment.y[0] + yTrans) * scale;
-				verQuad[quadraticCount + 2] = (segment.x[1] + xTrans) * scale; verQuad[quadraticCount + 3] = (segment.y[1] + yTrans) * scale;
-				verQuad[quadraticCount + 4] = (segment.x[2] + xTrans) * scale; verQuad[quadraticCount + 5] = (segment.y[2] + yTrans) * scale;
-				verQuad[quadraticCount + 6] = (0.f + xTrans) * scale; verQuad[quadraticCount + 7] = (0.f + yTrans) * scale;
-				quadraticCount += 8;
-			}
-			else if (segment.degree == 3){
-				verCub[cubicCount] = (segment.x[0] + xTrans) * scale; verCub[cubicCount + 1] = (segment.y[0] + yTrans) * scale;
-				verCub[cubicCount + 2] = (segment.x[1] + xTrans) * scale; verCub[cubicCount + 3] = (segment.y[1] + yTrans) * scale;
-				verCub[cubicCount + 4] = (segment.x[2] + xTrans) * scale; verCub[cubicCount + 5] = (segment.y[2] + yTrans) * scale;
-				verCub[cubicCount + 6] = (segment.x[3] + xTrans) * scale; verCub[cubicCount + 7] = (segment.y[3] + yTrans) * scale;
-				cubicCount += 8;
-			}
-		}
-	}
+// uploads the text into the fill geometry the current fill mode draws
+void InitializeTextFill(InstancedGlyphGeometry &text){
+	if (fillMode == FILL_MESH
+		&& !InitializeInstancedGeometry(&geomFill, text, InstancedGlyphGeometry::TRIANGLES))
+		cout << "Program failed to intialize geometry!" << endl;
+	if (fillMode == FILL_CURVES
+		&& (!InitializeInstancedGeometry(&geomCurveSolids, text, InstancedGlyphGeometry::CURVE_SOLIDS)
+		|| !InitializeInstancedGeometry(&geomCurveQuadratics, text, InstancedGlyphGeometry::CURVE_QUADRATICS)
+		|| !InitializeInstancedGeometry(&geomCurveCubics, text, InstancedGlyphGeometry::CURVE_CUBICS)))
+		cout << "Program failed to intialize geometry!" << endl;
+}
+
+// uploads the text into the line, quadratic, cubic and fill geometries
+void InitializeTextGeometry(InstancedGlyphGeometry &text){
+	if (!InitializeInstancedGeometry(&geomLines, text, InstancedGlyphGeometry::LINES))
+		cout << "Program failed to intialize geometry!" << endl;
+	if (!InitializeInstancedGeometry(&geomQuad, text, InstancedGlyphGeometry::QUADRATICS))
+		cout << "Program failed to intialize geometry!" << endl;
+	if (!InitializeInstancedGeometry(&geomCubic, text, InstancedGlyphGeometry::CUBICS))
+		cout << "Program failed to intialize geometry!" << endl;
+	InitializeTextFill(text);
 }
 
 // reports GLFW errors
@@ -339,7 +635,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			-1.f, 1.f, 0.f, 1.f, 1.f, 1.f, 0.f, 0.f,
 			1.2f, 0.5f, 2.5f, 1.f, 1.3f, -0.4f, 0.f, 0.f
 		};
-		float verArrayLines[elements*4];
+		float verArrayLines[elements*2];
 		int i = 0;
 		int j = 0;
 		while (i < elements * 2){
@@ -347,9 +643,6 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			verArrayLines[j] = verArrayQuad[i+1];	j++;
 			verArrayLines[j] = verArrayQuad[i+2];	j++;
 			verArrayLines[j] = verArrayQuad[i+3];	j++;
-			for (int temp = 0; temp < 4; temp++){
-				verArrayLines[j] = 0.f; j++;
-			}
 			i+=2;
 			if (i%4 == 0)
 				i+=4;
@@ -400,7 +693,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		if (!InitializeGeometry(&geomPoints, verArrayPoints, colsQuad, elements*4, scale, transform))
 			cout << "Program failed to intialize geometry!" << endl;
 		
-		if (!InitializeGeometry(&geomLines, verArrayLines, colsQuad, elements*2, scale, transform))
+		if (!InitializeGeometry(&geomLines, verArrayLines, colsQuad, elements, scale, transform))
 			cout << "Program failed to intialize geometry!" << endl;
 	}
 	
@@ -433,7 +726,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			5.f, 3.f, 5.3f, 2.8f, 5.3f, 2.2f, 5.f, 2.f,
 		};
 		
-		float verArrayLines[elements*6];
+		float verArrayLines[elements*3];
 		int counter = 0;
 		int i = 0;
 		int j = 0;
@@ -442,9 +735,6 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			verArrayLines[j] = verArrayCubic[i+1];	j++;
 			verArrayLines[j] = verArrayCubic[i+2];	j++;
 			verArrayLines[j] = verArrayCubic[i+3];	j++;
-			for (int temp = 0; temp < 4; temp++){
-				verArrayLines[j] = 0.f; j++;
-			}
 			counter += 2;
 			i += 2;
 			if (counter%6 == 0){
@@ -511,13 +801,12 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		if (!InitializeGeometry(&geomPoints, verArrayPoints, cols, elements*4, scale, transform))
 			cout << "Program failed to intialize geometry!" << endl;
 		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, elements*3, scale, transform))
+		if (!InitializeGeometry(&geomLines, verArrayLines, cols, elements*3/2, scale, transform))
 			cout << "Program failed to intialize geometry!" << endl;
 	}
 	
 	if (key == GLFW_KEY_3 && action == GLFW_PRESS) {
 		printPoints = false;printLinear = true; printQuad = true; printCubic = false;
-		float transform = 0.f; float scale = 1.f;
 		scroll = false;
 		awesome = false;
 		text = true;
@@ -528,38 +817,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			glUniform1i(loc, text);
 			
 		extractor.LoadFontFile("Fonts/Lora-Italic.ttf");
-		for (unsigned i = 0; i < name.size(); i++){
-			glyph = extractor.ExtractGlyph(name[i]);
-			glyphCount();
-		}
-		float verArrayLines[lineCount];
-		float verArrayQuad[quadraticCount];
-		float verArrayCub[cubicCount];
-		float adv = 0.f;
-		lineCount = 0;
-		quadraticCount = 0;
-		cubicCount = 0;
-		
-		for (unsigned i = 0; i < name.size(); i++){
-			glyph = extractor.ExtractGlyph(name[i]);
-			glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.55f, -1.8f + adv, -0.39f);
-			adv += glyph.advance - 0.08f;
-		}
-		
-		float cols[quadraticCount * 3 / 2];
-		for (int i = 0; i < quadraticCount * 3 / 2; i++){
-			cols[i] = 1.f;
-		}
-		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
+		extractor.ExtractString(name, run);
+		textGeometry.Clear();
+		textGeometry.AppendRun(run, 0.48f, -1.95f, -0.39f);
+		InitializeTextGeometry(textGeometry);
 	}
 	
 	if (key == GLFW_KEY_5 && action == GLFW_PRESS) {
 		printPoints = false; printLinear = true; printQuad = true; printCubic = false;
-		float transform = 0.f; float scale = 1.f;
 		scroll = false;
 		awesome = false;
 		text = true;
@@ -570,39 +835,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			glUniform1i(loc, text);
 			
 		extractor.LoadFontFile("Fonts/Comic_Sans.ttf");
-		for (unsigned i = 0; i < name.size(); i++){
-			glyph = extractor.ExtractGlyph(name[i]);
-			glyphCount();
-		}
-		
-		float verArrayLines[lineCount];
-		float verArrayQuad[quadraticCount];
-		float verArrayCub[cubicCount];
-		float adv = 0.f;
-		lineCount = 0;
-		quadraticCount = 0;
-		cubicCount = 0;
-		
-		for (unsigned i = 0; i < name.size(); i++){
-			glyph = extractor.ExtractGlyph(name[i]);
-			glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.5f, -2.f + adv, -0.39f);
-			adv += glyph.advance - 0.08f;
-		}
-		
-		float cols[quadraticCount * 3 / 2];
-		for (int i = 0; i < quadraticCount * 3 / 2; i++){
-			cols[i] = 1.f;
-		}
-		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
+		extractor.ExtractString(name, run);
+		textGeometry.Clear();
+		textGeometry.AppendRun(run, 0.44f, -2.17f, -0.39f);
+		InitializeTextGeometry(textGeometry);
 	}
 	
 	if (key == GLFW_KEY_4 && action == GLFW_PRESS) {
 		printPoints = false; printLinear = true; printQuad = true; printCubic = true;
-		float transform = 0.f; float scale = 1.f;
 		scroll = false; awesome = false; text = true;
 		
 		glUseProgram(shader.program);
@@ -612,43 +852,16 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		
 		//Load a font file and extract a glyph
 		extractor.LoadFontFile("Fonts/SourceSansPro-ExtraLight.otf");
-		for (unsigned i = 0; i < name.size(); i++){
-			glyph = extractor.ExtractGlyph(name[i]);
-			glyphCount();
-		}
-		
-		float verArrayLines[lineCount];
-		float verArrayQuad[quadraticCount];
-		float verArrayCub[cubicCount];
-		float adv = 0.f;
-		lineCount = 0;
-		quadraticCount = 0;
-		cubicCount = 0;
-		
-		for (unsigned i = 0; i < name.size(); i++){
-			glyph = extractor.ExtractGlyph(name[i]);
-			glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.7f, -1.43f + adv, -0.39f);
-                        adv += glyph.advance - 0.10f;
-		}
-		
-		float cols[cubicCount * 3 / 2];
-		for (int i = 0; i < quadraticCount * 3 / 2; i++){
-			cols[i] = 1.f;
-		}
-		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomCubic, verArrayCub, cols, cubicCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
+		extractor.ExtractString(name, run);
+		textGeometry.Clear();
+		textGeometry.AppendRun(run, 0.57f, -1.66f, -0.39f);
+		InitializeTextGeometry(textGeometry);
 	}
 
 	if (key == GLFW_KEY_6 && action == GLFW_PRESS) {
 		printPoints = false; printLinear = true; printQuad = true; printCubic = false;
-		float transform = 0.f; float scale = 1.f;
 		scroll = true; awesome = false; text = true;
-		scrollBound = -12.f;
+		scrollBound = -13.5f;
 		
 		glUseProgram(shader.program);
 		GLint loc = glGetUniformLocation(shader.program, "text");
@@ -657,39 +870,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		
 		//Load a font file and extract a glyph
 		extractor.LoadFontFile("Fonts/Comic_Sans.ttf");
-		for (unsigned i = 0; i < fox.size(); i++){
-			glyph = extractor.ExtractGlyph(fox[i]);
-			glyphCount();
-		}
-		
-		float verArrayLines[lineCount];
-		float verArrayQuad[quadraticCount];
-		float verArrayCub[cubicCount];
-		float adv = 0.f;
-		lineCount = 0;
-		quadraticCount = 0;
-		cubicCount = 0;
-		
-		for (unsigned i = 0; i < fox.size(); i++){
-			glyph = extractor.ExtractGlyph(fox[i]);
-			glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.5f, 2.f + adv, -0.39f);
-			adv += glyph.advance - 0.08f;
-		}
-		
-		float cols[quadraticCount * 3 / 2];
-		for (int i = 0; i < quadraticCount * 3 / 2; i++){
-			cols[i] = 1.f;
-		}
-		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
+		extractor.ExtractString(fox, run);
+		textGeometry.Clear();
+		textGeometry.AppendRun(run, 0.5f, 2.f, -0.39f);
+		InitializeTextGeometry(textGeometry);
 	}
 
 	if (key == GLFW_KEY_7 && action == GLFW_PRESS) {
 		printPoints = false; printLinear = true; printQuad = true; printCubic = false;
-		float transform = 0.f; float scale = 1.f;
 		scroll = true; awesome = false; text = true;
 		scrollBound = -11.f;
 		
@@ -700,39 +888,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		
 		//Load a font file and extract a glyph
 		extractor.LoadFontFile("Fonts/AlexBrush-Regular.ttf");
-		for (unsigned i = 0; i < fox.size(); i++){
-			glyph = extractor.ExtractGlyph(fox[i]);
-			glyphCount();
-		}
-		
-		float verArrayLines[lineCount];
-		float verArrayQuad[quadraticCount];
-		float verArrayCub[cubicCount];
-		float adv = 0.f;
-		lineCount = 0;
-		quadraticCount = 0;
-		cubicCount = 0;
-		
-		for (unsigned i = 0; i < fox.size(); i++){
-			glyph = extractor.ExtractGlyph(fox[i]);
-			glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.5f, 2.f + adv, -0.39f);
-			adv += glyph.advance;
-		}
-		
-		float cols[quadraticCount * 3 / 2];
-		for (int i = 0; i < quadraticCount * 3 / 2; i++){
-			cols[i] = 1.f;
-		}
-		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
+		extractor.ExtractString(fox, run);
+		textGeometry.Clear();
+		textGeometry.AppendRun(run, 0.5f, 2.f, -0.39f);
+		InitializeTextGeometry(textGeometry);
 	}
 	
 	if (key == GLFW_KEY_8 && action == GLFW_PRESS) {
 		printPoints = false; printLinear = true; printQuad = true; printCubic = true;
-		float transform = 0.f; float scale = 1.f;
 		scroll = true; awesome = false; text = true;
 		scrollBound = -13.f;
 		
@@ -743,36 +906,10 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		
 		//Load a font file and extract a glyph
 		extractor.LoadFontFile("Fonts/Inconsolata.otf");
-		for (unsigned i = 0; i < fox.size(); i++){
-			glyph = extractor.ExtractGlyph(fox[i]);
-			glyphCount();
-		}
-		
-		float verArrayLines[lineCount];
-		float verArrayQuad[quadraticCount];
-		float verArrayCub[cubicCount];
-		float adv = 0.f;
-		lineCount = 0;
-		quadraticCount = 0;
-		cubicCount = 0;
-		
-		for (unsigned i = 0; i < fox.size(); i++){
-			glyph = extractor.ExtractGlyph(fox[i]);
-			glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.5f, 2.f + adv, -0.39f);
-			adv += glyph.advance;
-		}
-		
-		float cols[quadraticCount * 3 / 2];
-		for (int i = 0; i < quadraticCount * 3 / 2; i++){
-			cols[i] = 1.f;
-		}
-		
-		if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
-		if (!InitializeGeometry(&geomCubic, verArrayCub, cols, cubicCount / 2, scale, transform))
-			cout << "Program failed to intialize geometry!" << endl;
+		extractor.ExtractString(fox, run);
+		textGeometry.Clear();
+		textGeometry.AppendRun(run, 0.5f, 2.f, -0.39f);
+		InitializeTextGeometry(textGeometry);
 	}
 	
 	if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
@@ -803,6 +940,37 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 	if (key == GLFW_KEY_DOWN && action == GLFW_PRESS) {
 		scrollSpeed *= 0.8f;
 	}
+	if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+		PrintBufferPoolStats();
+	}
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+		adaptiveTessellation = !adaptiveTessellation;
+		PrintTessellationStats();
+	}
+	if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+		PrintTessellationStats();
+	}
+	if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+		const char *modes[FILL_MODE_COUNT] = { "off", "triangulated meshes", "curve fill" };
+		fillMode = (fillMode + 1) % FILL_MODE_COUNT;
+		ConfigureTextFill(textGeometry);
+		textGeometry.RebuildFill();
+		InitializeTextFill(textGeometry);
+		cout << "Filled text: " << modes[fillMode] << ", " << meshCache.Size()
+			<< " glyph meshes cached (" << meshCache.Bytes() / 1024 << " KB), "
+			<< (textGeometry.Vertices(InstancedGlyphGeometry::CURVE_SOLIDS)
+				+ textGeometry.Vertices(InstancedGlyphGeometry::CURVE_QUADRATICS)
+				+ textGeometry.Vertices(InstancedGlyphGeometry::CURVE_CUBICS)) / 3
+			<< " curve fill triangles" << endl;
+	}
+	if (key == GLFW_KEY_MINUS && action == GLFW_PRESS) {
+		pixelTolerance *= 0.5f;
+		PrintTessellationStats();
+	}
+	if (key == GLFW_KEY_EQUAL && action == GLFW_PRESS) {
+		pixelTolerance *= 2.f;
+		PrintTessellationStats();
+	}
 }
 
 // ==========================================================================
@@ -823,6 +991,7 @@ int main(int argc, char *argv[])
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_STENCIL_BITS, 8);
 	window = glfwCreateWindow(1024, 1024, "Susant's A3 HALLOWEEN EDITION", 0, 0);
 	if (!window) {
 		cout << "Program failed to create GLFW window, TERMINATING" << endl;
@@ -847,13 +1016,16 @@ int main(int argc, char *argv[])
 	QueryGLVersion();
 
 	// call function to load and compile shader programs
-	if (!InitializeShaders(&shader)) {
+	if (!InitializeShaders(&shader) || !InitializeLineShader(&lineShader)
+		|| !InitializeCurveShader(&curveShader)) {
 		cout << "Program could not initialize shaders, TERMINATING" << endl;
 		return -1;
 	}
 	
+	// geometry without per-instance transforms is drawn untransformed
+	glVertexAttrib3f(INSTANCE_INDEX, 0.f, 0.f, 1.f);
+
 	printPoints = false; printLinear = true; printQuad = true; printCubic = false;
-	float transform = 0.f; float scale = 1.f;
 	scroll = false;
 	
 	string intro = "Welcome to Susant\"s A3HALLOWEEN EDITION";
@@ -863,46 +1035,28 @@ int main(int argc, char *argv[])
 	if (loc != -1)
 		glUniform1i(loc, true);
 	
-	//Load a font file and extract a glyph
-	extractor.LoadFontFile("Fonts/Dreamscar.ttf");
-	for (unsigned i = 0; i < intro.size(); i++){
-		glyph = extractor.ExtractGlyph(intro[i]);
-		glyphCount();
-	}
-	
-	float verArrayLines[lineCount];
-	float verArrayQuad[quadraticCount];
-	float verArrayCub[cubicCount];
-	float adv = 0.f;
-	lineCount = 0;
-	quadraticCount = 0;
-	cubicCount = 0;
-	
-	for (unsigned i = 0; i < 22; i++){
-		glyph = extractor.ExtractGlyph(intro[i]);
-		glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.1f, -5.5f + adv, 1.f);
-		adv += glyph.advance;
-	}
-	
-	adv = 0.f;
-	
-	for (unsigned i = 22; i < intro.size(); i++){
-		glyph = extractor.ExtractGlyph(intro[i]);
-		glyphToGeom(verArrayLines, verArrayQuad, verArrayCub, 0.17f, -4.5f + adv, -1.f);
-		adv += glyph.advance;
+	//Use the precompiled glyph bank if 'make banks' has built one, otherwise
+	//load the font file and extract the glyphs with FreeType; the bank keeps
+	//the font's kerning, so both lay the intro out identically
+	MyGlyphRun introBottom;
+	GlyphBank introBank;
+	if (introBank.Open("Fonts/Dreamscar.bank")) {
+		introBank.ExtractString(intro.substr(0, 22), run);
+		introBank.ExtractString(intro.substr(22), introBottom);
 	}
-	
-	float cols[quadraticCount * 3 / 2];
-	for (int i = 0; i < quadraticCount * 3 / 2; i++){
-		cols[i] = 1.f;
+	else {
+		extractor.LoadFontFile("Fonts/Dreamscar.ttf");
+		extractor.ExtractString(intro.substr(0, 22), run);
+		extractor.ExtractString(intro.substr(22), introBottom);
 	}
-	
-	if (!InitializeGeometry(&geomLines, verArrayLines, cols, lineCount / 2, scale, transform))
-		cout << "Program failed to intialize geometry!" << endl;
-	if (!InitializeGeometry(&geomQuad, verArrayQuad, cols, quadraticCount / 2, scale, transform))
-		cout << "Program failed to intialize geometry!" << endl;
+	ConfigureTextFill(textGeometry);
+	textGeometry.Clear();
+	textGeometry.AppendRun(run, 0.1f, -5.5f, 1.f);
+	textGeometry.AppendRun(introBottom, 0.17f, -4.5f, -1.f);
+	InitializeTextGeometry(textGeometry);
 
 	glPatchParameteri(GL_PATCH_VERTICES, 4);
+	glGenQueries(1, &primitiveQuery);
 
 	double lastTime = glfwGetTime();
 	int nbFrames = 0;
@@ -932,20 +1086,50 @@ int main(int argc, char *argv[])
 		GLint loc = glGetUniformLocation(shader.program, "scrollFactor");
 		if (loc != -1)
 			glUniform1f(loc, scrollFactor);
-		// call function to draw our scene
+
+		// tessellation levels follow the on-screen size of each patch
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		loc = glGetUniformLocation(shader.program, "viewport");
+		if (loc != -1)
+			glUniform2f(loc, float(width), float(height));
+		loc = glGetUniformLocation(shader.program, "adaptive");
+		if (loc != -1)
+			glUniform1i(loc, adaptiveTessellation);
+		loc = glGetUniformLocation(shader.program, "pixelTolerance");
+		if (loc != -1)
+			glUniform1f(loc, pixelTolerance);
+
+		// call function to draw our scene, then collect the count of
+		// tessellated primitives once it has arrived
 		RenderScene(&shader); //render scene with texture
+		GLint available = 0;
+		glGetQueryObjectiv(primitiveQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			glGetQueryObjectuiv(primitiveQuery, GL_QUERY_RESULT, &primitivesGenerated);
+			primitiveQueryPending = false;
+		}
 								
 		glfwSwapBuffers(window);
 
 		glfwPollEvents();
 	}
 
+	PrintBufferPoolStats();
+
 	// clean up allocated resources before exit
 	DestroyGeometry(&geomPoints);
 	DestroyGeometry(&geomLines);
 	DestroyGeometry(&geomQuad);
 	DestroyGeometry(&geomCubic);
+	DestroyGeometry(&geomFill);
+	DestroyGeometry(&geomCurveSolids);
+	DestroyGeometry(&geomCurveQuadratics);
+	DestroyGeometry(&geomCurveCubics);
+	glDeleteQueries(1, &primitiveQuery);
 	DestroyShaders(&shader);
+	DestroyShaders(&lineShader);
+	DestroyShaders(&curveShader);
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
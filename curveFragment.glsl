@@ -0,0 +1,23 @@
+// ==========================================================================
+// Fragment program for resolution-independent curve fill
+//
+// Curve triangles carry (k, l, m) coordinates for which k^3 - l m is zero
+// on the curve and negative between the curve and its chord; fragments on
+// the other side are discarded. Interior triangles carry (-1, 0, 0) and are
+// never discarded.
+// ==========================================================================
+#version 410
+
+// interpolated colour and curve coordinates received from vertex stage
+in vec3 Colour;
+in vec3 Curve;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+void main(void)
+{
+    if (Curve.x * Curve.x * Curve.x - Curve.y * Curve.z > 0.0)
+        discard;
+    FragmentColour = vec4(Colour, 0);
+}
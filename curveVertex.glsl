@@ -0,0 +1,46 @@
+// ==========================================================================
+// Vertex program for resolution-independent curve fill
+//
+// Places the fill triangles of glyphs (see CurveFill.h) as lineVertex.glsl
+// places straight segments, and passes each vertex's implicit curve
+// coordinates on to be interpolated across the triangle. Quadratic curve
+// triangles are stored as positions only and take the canonical
+// coordinates of their corner, which is the vertex index modulo 3, since
+// every outline's triangles start at a multiple of 3.
+// ==========================================================================
+#version 410
+
+// location indices for these attributes correspond to those specified in the
+// InitializeInstancedGeometry() function of the main program
+layout(location = 0) in vec2 VertexPosition;
+layout(location = 2) in vec3 InstanceTransform;
+layout(location = 3) in vec3 CurveCoordinates;
+
+// output passed straight to the fragment stage
+out vec3 Colour;
+out vec3 Curve;
+
+uniform bool awesome = false;
+uniform bool quadratic = false;
+uniform bool scroll = false;
+uniform float scrollFactor;
+
+void main()
+{
+	vec2 position = (VertexPosition + InstanceTransform.xy) * InstanceTransform.z;
+	vec2 newPos = position;
+	if (scroll){
+		if (!awesome){
+			newPos = vec2(position.x + scrollFactor, position.y);
+		} else {
+			float xPos = position.x + scrollFactor;
+			float yPos = (xPos + 1.f) / 2.f;
+			newPos = vec2(xPos, position.y / yPos);
+		}
+	}
+    gl_Position = vec4(newPos, 0.0, 1.0);
+
+    Colour = vec3(1.f, 1.f, 1.f);
+    const vec3 corners[3] = vec3[3](vec3(0.0, 0.0, 0.0), vec3(0.5, 0.0, 0.5), vec3(1.0, 1.0, 1.0));
+    Curve = quadratic ? corners[gl_VertexID % 3] : CurveCoordinates;
+}
@@ -0,0 +1,40 @@
+// ==========================================================================
+// Vertex program for straight line segments
+//
+// Straight segments are drawn as GL_LINES without tessellation, so this
+// stage applies the same placement and scrolling as vertex.glsl and also
+// chooses the colour that tessEval.glsl would give a degree-1 segment.
+// ==========================================================================
+#version 410
+
+// location indices for these attributes correspond to those specified in the
+// InitializeGeometry() function of the main program
+layout(location = 0) in vec2 VertexPosition;
+layout(location = 2) in vec3 InstanceTransform;
+
+// output passed straight to the fragment stage
+out vec3 Colour;
+
+uniform bool awesome = false;
+uniform bool scroll = false;
+uniform float scrollFactor;
+uniform bool text = false;
+
+void main()
+{
+	vec2 position = (VertexPosition + InstanceTransform.xy) * InstanceTransform.z;
+	vec2 newPos = position;
+	if (scroll){
+		if (!awesome){
+			newPos = vec2(position.x + scrollFactor, position.y);
+		} else {
+			float xPos = position.x + scrollFactor;
+			float yPos = (xPos + 1.f) / 2.f;
+			newPos = vec2(xPos, position.y / yPos);
+		}
+	}
+    gl_Position = vec4(newPos, 0.0, 1.0);
+
+    // grey control polygons, white text
+    Colour = text ? vec3(1.f, 1.f, 1.f) : vec3(0.3f, 0.3f, 0.3f);
+}
@@ -18,18 +18,55 @@
 // per vertex out, use "out <type> <name>"
 // per patch out, use  "patch out <type> <name>"
 
+// With adaptive tessellation the subdivision level of each patch follows
+// its size on screen: Wang's formula gives the number of line pieces that
+// keeps a degree-n Bezier within [pixelTolerance] pixels of its chords,
+// n(n-1)/8 * max|P[i] - 2P[i+1] + P[i+2]| / tolerance, square rooted, and
+// the control polygon length bounds it so no piece is much shorter than a
+// pixel. Without it every patch gets the fixed level of 100, which like the
+// adaptive level is clamped to maxLevel: 64 is the smallest
+// GL_MAX_TESS_GEN_LEVEL an implementation may have, and beyond it the
+// hardware would clamp the level anyway.
+
 #version 410
 layout(vertices = 4) out; //How long gl_out[] should be
 
 in vec3 tcColour[];
 out vec3 teColour[];
 
+uniform int bezierType = 2;
+uniform bool adaptive = true;
+uniform vec2 viewport = vec2(1024.0, 1024.0);  // framebuffer size in pixels
+uniform float pixelTolerance = 0.25;
+uniform float maxLevel = 64.0;
+
+// control point in pixels (clip space is the window, w = 1)
+vec2 pixel(int i) {
+    return gl_in[i].gl_Position.xy * 0.5 * viewport;
+}
+
+float adaptiveLevel() {
+    // curve degree of this patch; control point crosses are cubics
+    int degree = (bezierType == 2) ? 2 : 3;
+    vec2 p0 = pixel(0), p1 = pixel(1), p2 = pixel(2), p3 = pixel(3);
+
+    float flatness = length(p0 - 2.0 * p1 + p2);
+    float polygon = length(p1 - p0) + length(p2 - p1);
+    if (degree == 3) {
+        flatness = max(flatness, length(p1 - 2.0 * p2 + p3));
+        polygon += length(p3 - p2);
+    }
+
+    float wang = ceil(sqrt(float(degree * (degree - 1)) / 8.0 * flatness / pixelTolerance));
+    return clamp(min(wang, ceil(polygon)), 1.0, maxLevel);
+}
+
 void main()
 {
     // gl_InvocationID tells you what input vertex you are working on
     if (gl_InvocationID == 0) {   // only needs to be set once
         gl_TessLevelOuter[0] = 1; // only need to draw one line
-        gl_TessLevelOuter[1] = 100; // how much to subdivide each line
+        gl_TessLevelOuter[1] = adaptive ? adaptiveLevel() : min(100.0, maxLevel); // how much to subdivide each line
     }
     gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;	// pass control points to TES
     teColour[gl_InvocationID] = tcColour[gl_InvocationID]; 						// pass colours to TES
@@ -0,0 +1,123 @@
+// ==========================================================================
+// Bezier kernel microbenchmark
+//
+// Collects every quadratic and cubic segment of each font's character set
+// and evaluates them at 17 parameter values (16 steps) with each
+// instruction set the CPU supports, reporting point evaluations per second
+// and the largest deviation from direct Bernstein evaluation. Usage:
+//
+//     tools/bezier_bench [font files...]      (defaults to a few in Fonts/)
+// ==========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include "BezierKernels.h"
+#include "Tessellator.h"
+
+using namespace std;
+
+static const int STEPS = 16;
+
+// largest distance of the kernel output from PatchTessellator::Evaluate
+static float MaxError(const BezierSoA &segments, const vector<float> &x, const vector<float> &y)
+{
+    float worst = 0.f;
+    size_t count = segments.Count();
+    for (size_t i = 0; i < count; ++i)
+    {
+        float patch[8] = { 0 };
+        for (int p = 0; p <= segments.degree; ++p) {
+            patch[2*p] = segments.x[p][i];
+            patch[2*p + 1] = segments.y[p][i];
+        }
+        for (int k = 0; k <= STEPS; ++k)
+        {
+            float ex, ey;
+            PatchTessellator::Evaluate(patch, segments.degree, float(k) / STEPS, ex, ey);
+            worst = max(worst, max(fabs(ex - x[k * count + i]), fabs(ey - y[k * count + i])));
+        }
+    }
+    return worst;
+}
+
+static void Benchmark(const BezierSoA &segments)
+{
+    size_t count = segments.Count();
+    if (count == 0) return;
+    vector<float> x((STEPS + 1) * count), y((STEPS + 1) * count);
+
+    // repeat each pass until it lasts long enough to time reliably
+    int repeats = max(1, int(2000000 / (count * (STEPS + 1))));
+    double scalarRate = 0.0;
+
+    BezierISA isas[] = { BEZIER_SCALAR, BEZIER_SSE2, BEZIER_AVX2 };
+    for (int n = 0; n < 3; ++n)
+    {
+        BezierISA isa = isas[n];
+        if (!BezierKernels::Supported(isa)) {
+            cout << "    " << setw(7) << BezierKernels::Name(isa) << "  not supported" << endl;
+            continue;
+        }
+
+        double best = 0.0;
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r)
+                BezierKernels::Evaluate(segments, STEPS, &x[0], &y[0], isa);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (pass == 0 || seconds < best) best = seconds;
+        }
+
+        double rate = double(repeats) * count * (STEPS + 1) / best;
+        if (isa == BEZIER_SCALAR) scalarRate = rate;
+        cout << "    " << setw(7) << BezierKernels::Name(isa) << "  " << fixed << setprecision(1)
+             << setw(8) << rate / 1e6 << " M evaluations/s  " << setprecision(2)
+             << rate / scalarRate << "x  max error " << scientific << setprecision(2)
+             << MaxError(segments, x, y) << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> fonts;
+    for (int i = 1; i < argc; ++i) fonts.push_back(argv[i]);
+    if (fonts.empty()) {
+        fonts.push_back("Fonts/Lora-Regular.ttf");
+        fonts.push_back("Fonts/SourceSansPro-Regular.otf");
+    }
+
+    cout << "best instruction set: " << BezierKernels::Name(BezierKernels::Best()) << endl;
+    for (size_t f = 0; f < fonts.size(); ++f)
+    {
+        GlyphExtractor extractor;
+        if (!extractor.LoadFontFile(fonts[f])) continue;
+
+        // every outline of the font in EM units, split by degree
+        GlyphGeometry geometry;
+        MyPackedGlyph packed;
+        vector<int> characters = extractor.CharacterSet();
+        for (size_t i = 0; i < characters.size(); ++i)
+            geometry.AppendGlyph(extractor.ExtractGlyph(characters[i], packed), 1.f, 0.f, 0.f);
+
+        BezierSoA quadratics(2), cubics(3);
+        quadratics.AppendPatches(geometry.Quadratics(), geometry.QuadraticVertices());
+        cubics.AppendPatches(geometry.Cubics(), geometry.CubicVertices());
+
+        cout << fonts[f] << ": " << quadratics.Count() << " quadratic, "
+             << cubics.Count() << " cubic segments" << endl;
+        if (quadratics.Count()) {
+            cout << "  quadratic" << endl;
+            Benchmark(quadratics);
+        }
+        if (cubics.Count()) {
+            cout << "  cubic" << endl;
+            Benchmark(cubics);
+        }
+    }
+    return 0;
+}
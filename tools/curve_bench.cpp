@@ -0,0 +1,203 @@
+// ==========================================================================
+// Curve fill benchmark and verification
+//
+// Builds the resolution-independent fill meshes (see CurveFill.h) for the
+// whole character set of each font, reporting glyphs built per second, the
+// size of the meshes next to the triangulated meshes of GlyphMesh.h at the
+// given EM size and to the line segments of tessellating every curve at a
+// fixed level of 100, and how many cubics fell into each class. The mesh
+// size is also given as it would be with (k, l, m) stored in every vertex.
+//
+// Each mesh is then drawn on the CPU as the GPU draws it: 16 samples per
+// pixel, a sample counted when it is inside a triangle and k^3 - l m <= 0
+// there, with the triangle's orientation added to its winding, and nonzero
+// samples painted. The result is compared with the outline filled by the
+// Rasterizer, at the EM size for every glyph and at eight times that size
+// for the printable ASCII characters, and the pixels differing by more than
+// 96 of 255 are counted (sampling alone can be a quarter pixel, 64, off
+// along a straight edge). Usage:
+//
+//     tools/curve_bench [--em pixels] [font files...]
+//
+// The default EM is 64 pixels.
+// ==========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "CurveFill.h"
+#include "GlyphMesh.h"
+#include "Rasterizer.h"
+
+using namespace std;
+
+// placement of a glyph in a canvas two EMs square, in EM units
+static const float X_TRANS = -0.5f, Y_TRANS = -0.3f;
+
+// draws a curve fill mesh with 4 x 4 samples per pixel into an image of
+// [size] x [size] pixels, with [em] pixels per EM, counting covered samples
+static void DrawSamples(const CurveMesh &curveMesh, float em, int size, vector<unsigned char> &coverage)
+{
+    const int STRIDE = CurveFill::VERTEX_FLOATS;
+    vector<float> mesh;
+    CurveFill::Expand(curveMesh, mesh);
+    int samples = size * 4;
+    vector<int> winding(size_t(samples) * samples, 0);
+
+    for (size_t t = 0; t + 3 * STRIDE <= mesh.size(); t += 3 * STRIDE)
+    {
+        // corners in sample units, +y down
+        float sx[3], sy[3];
+        for (int v = 0; v < 3; ++v) {
+            sx[v] = (mesh[t + v * STRIDE] + X_TRANS + 1.f) * em * 4.f;
+            sy[v] = (1.f - mesh[t + v * STRIDE + 1] - Y_TRANS) * em * 4.f;
+        }
+        float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+        if (area == 0.f) continue;
+        int direction = area > 0.f ? 1 : -1;
+
+        int x0 = max(0, int(floor(min(sx[0], min(sx[1], sx[2])))));
+        int x1 = min(samples - 1, int(ceil(max(sx[0], max(sx[1], sx[2])))));
+        int y0 = max(0, int(floor(min(sy[0], min(sy[1], sy[2])))));
+        int y1 = min(samples - 1, int(ceil(max(sy[0], max(sy[1], sy[2])))));
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+            {
+                float px = x + 0.5f, py = y + 0.5f, w[3];
+                bool inside = true;
+                for (int e = 0; e < 3 && inside; ++e) {
+                    int a = (e + 1) % 3, b = (e + 2) % 3;
+                    w[e] = ((sx[b] - sx[a]) * (py - sy[a]) - (sy[b] - sy[a]) * (px - sx[a])) / area;
+                    inside = w[e] > 0.f;
+                }
+                if (!inside) continue;
+
+                float klm[3];
+                for (int c = 0; c < 3; ++c)
+                    klm[c] = w[0] * mesh[t + 2 + c] + w[1] * mesh[t + STRIDE + 2 + c]
+                           + w[2] * mesh[t + 2 * STRIDE + 2 + c];
+                if (CurveFill::Implicit(klm[0], klm[1], klm[2]) <= 0.f)
+                    winding[size_t(y) * samples + x] += direction;
+            }
+    }
+
+    coverage.assign(size_t(size) * size, 0);
+    for (int y = 0; y < samples; ++y)
+        for (int x = 0; x < samples; ++x)
+            if (winding[size_t(y) * samples + x])
+                coverage[size_t(y / 4) * size + x / 4] += 1;
+}
+
+// pixels differing by more than 96 between the sampled mesh and the
+// Rasterizer's fill of the outline
+static int CoverageDifference(const MyGlyphView &glyph, const CurveMesh &mesh, float em)
+{
+    int size = int(2.f * em);
+    Framebuffer outline(size, size);
+    outline.Clear(0.f, 0.f, 0.f);
+    Rasterizer rasterizer;
+    GlyphGeometry geometry;
+    geometry.AppendGlyph(glyph, 1.f, X_TRANS, Y_TRANS);
+    rasterizer.Begin(outline);
+    rasterizer.Fill(geometry);
+    rasterizer.Resolve(outline, 1.f, 1.f, 1.f);
+
+    vector<unsigned char> coverage;
+    DrawSamples(mesh, em, size, coverage);
+
+    int differing = 0;
+    for (size_t i = 0; i < coverage.size(); ++i)
+        differing += abs(int(outline.pixels[4 * i]) - min(16 * coverage[i], 255)) > 96;
+    return differing;
+}
+
+int main(int argc, char *argv[])
+{
+    float em = 64.f;
+    vector<string> fonts;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--em") && i + 1 < argc)
+            em = atof(argv[++i]);
+        else
+            fonts.push_back(argv[i]);
+    }
+    if (fonts.empty()) {
+        fonts.push_back("Fonts/Lora-Regular.ttf");
+        fonts.push_back("Fonts/Comic_Sans.ttf");
+        fonts.push_back("Fonts/SourceSansPro-Regular.otf");
+        fonts.push_back("Fonts/SourceSansPro-ExtraLight.otf");
+        fonts.push_back("Fonts/Inconsolata.otf");
+    }
+    cout << "EM " << em << " px" << endl;
+
+    const char *classes[] = { "serpentine", "cusp", "loop", "quadratic", "line" };
+    for (size_t f = 0; f < fonts.size(); ++f)
+    {
+        GlyphExtractor extractor;
+        if (!extractor.LoadFontFile(fonts[f])) continue;
+
+        vector<int> characters = extractor.CharacterSet();
+        vector<MyGlyph> glyphs;
+        size_t curves = 0;
+        for (size_t i = 0; i < characters.size(); ++i)
+        {
+            glyphs.push_back(extractor.ExtractGlyph(characters[i]));
+            const MyGlyph &glyph = glyphs.back();
+            for (size_t c = 0; c < glyph.contours.size(); ++c)
+                for (size_t s = 0; s < glyph.contours[c].size(); ++s)
+                    curves += glyph.contours[c][s].degree >= 2 && glyph.contours[c][s].degree <= 3;
+        }
+
+        CurveMesh mesh;
+        size_t bytes = 0, triangleCount = 0;
+        double best = 0.0;
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            bytes = triangleCount = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (size_t i = 0; i < glyphs.size(); ++i) {
+                CurveFill::Build(glyphs[i], mesh);
+                bytes += mesh.Bytes();
+                triangleCount += mesh.Triangles();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (pass == 0 || seconds < best) best = seconds;
+        }
+
+        unsigned long counts[5] = { 0, 0, 0, 0, 0 };
+        Triangulator triangulator;
+        vector<float> triangles;
+        size_t triangulated = 0;
+        int differing = 0, large = 0;
+        MyPackedGlyph packed;
+        for (size_t i = 0; i < characters.size(); ++i)
+        {
+            MyGlyphView view = extractor.ExtractGlyph(characters[i], packed);
+            CurveFill::Build(view, mesh, counts);
+            triangulator.Triangulate(view, 0.25f / em, triangles);
+            triangulated += triangles.size();
+            differing += CoverageDifference(view, mesh, em);
+            if (characters[i] > 32 && characters[i] < 127)
+                large += CoverageDifference(view, mesh, 8.f * em);
+        }
+
+        size_t expanded = triangleCount * 3 * CurveFill::VERTEX_FLOATS * sizeof(float);
+        cout << fonts[f] << ": " << glyphs.size() << " glyphs in " << fixed << setprecision(2)
+             << best * 1000.0 << " ms (" << setprecision(0) << glyphs.size() / best
+             << " glyphs/s), " << triangleCount << " triangles, " << bytes / 1024
+             << " KB (" << expanded / 1024 << " KB with coordinates per vertex); triangulated "
+             << triangulated * sizeof(float) / 1024 << " KB, " << curves * 100
+             << " lines at level 100" << endl << "  cubics:";
+        for (int c = 0; c < 5; ++c)
+            if (counts[c]) cout << " " << counts[c] << " " << classes[c];
+        cout << endl << "  pixels differing: " << differing << " at " << setprecision(0) << em
+             << " px, " << large << " at " << 8.f * em << " px" << endl;
+        cout.unsetf(ios::floatfield);
+    }
+    return 0;
+}
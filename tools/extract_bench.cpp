@@ -0,0 +1,114 @@
+// ==========================================================================
+// Glyph extraction scaling benchmark
+//
+// Decodes the whole character set of each font with a GlyphExtractorPool at
+// 1, 2, 4 and N threads (N = hardware threads) and reports glyphs per second
+// and the speedup over one thread. Before that it checks the glyph cache:
+// laying out the same text twice with ExtractString must serve the second
+// pass from the cache, with no misses, or the tool fails. Usage:
+//
+//     tools/extract_bench [--cache-check] [font files...]
+//
+// The fonts default to a few in Fonts/. --cache-check runs only the check,
+// as 'make check' does.
+// ==========================================================================
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "GlyphExtractorPool.h"
+
+using namespace std;
+
+// lays out a pangram twice and reports whether the second pass was served
+// entirely from the glyph cache
+static bool CheckCache(const string &font)
+{
+    GlyphExtractor extractor;
+    if (!extractor.LoadFontFile(font)) return false;
+
+    const string text = "The Quick Brown Fox Jumps Over the Lazy Dog.";
+    MyGlyphRun run;
+    extractor.ExtractString(text, run);
+    unsigned long misses = extractor.CacheMisses(), hits = extractor.CacheHits();
+    extractor.ExtractString(text, run);
+    misses = extractor.CacheMisses() - misses;
+    hits = extractor.CacheHits() - hits;
+
+    cout << "  cache: second pass " << hits << " hits, " << misses << " misses, "
+         << extractor.CacheSize() << " outlines cached" << endl;
+    if (misses || extractor.CacheSize() != run.uniqueCount) {
+        cout << "FAIL: the second pass of " << font << " was not served from the cache" << endl;
+        return false;
+    }
+    return true;
+}
+
+// best of several timed passes over the character set, in seconds
+static double TimeCharset(GlyphExtractorPool &pool, size_t &glyphCount)
+{
+    vector<int> characters;
+    vector<MyGlyph> glyphs;
+    double best = 0.0;
+    for (int pass = 0; pass < 5; ++pass)
+    {
+        pool.ClearCache();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pool.ExtractCharset(characters, glyphs);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+    glyphCount = glyphs.size();
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> fonts;
+    bool cacheOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--cache-check")) cacheOnly = true;
+        else fonts.push_back(argv[i]);
+    }
+    if (fonts.empty()) {
+        fonts.push_back("Fonts/Lora-Regular.ttf");
+        fonts.push_back("Fonts/Comic_Sans.ttf");
+        fonts.push_back("Fonts/SourceSansPro-Regular.otf");
+    }
+
+    vector<unsigned int> threadCounts;
+    threadCounts.push_back(1);
+    threadCounts.push_back(2);
+    threadCounts.push_back(4);
+    unsigned int hardware = thread::hardware_concurrency();
+    if (hardware > 4) threadCounts.push_back(hardware);
+
+    cout << fixed << setprecision(1);
+    for (size_t f = 0; f < fonts.size(); ++f)
+    {
+        cout << fonts[f] << endl;
+        if (!CheckCache(fonts[f])) return 1;
+        if (cacheOnly) continue;
+
+        double baseline = 0.0;
+        for (size_t t = 0; t < threadCounts.size(); ++t)
+        {
+            GlyphExtractorPool pool(threadCounts[t]);
+            if (!pool.LoadFontFile(fonts[f])) break;
+
+            size_t glyphCount = 0;
+            double seconds = TimeCharset(pool, glyphCount);
+            double rate = glyphCount / seconds;
+            if (t == 0) baseline = rate;
+
+            cout << "  " << setw(3) << threadCounts[t] << " threads: "
+                 << setw(6) << glyphCount << " glyphs in " << setprecision(2)
+                 << seconds * 1000.0 << " ms, " << setprecision(0) << setw(9)
+                 << rate << " glyphs/s, speedup " << setprecision(2)
+                 << rate / baseline << "x" << setprecision(1) << endl;
+        }
+    }
+    return 0;
+}
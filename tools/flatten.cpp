@@ -0,0 +1,150 @@
+// ==========================================================================
+// Outline flattening benchmark
+//
+// Flattens the whole character set of each font with the adaptive
+// flattener (see Flattener.h) at a pixel tolerance for a given EM size, and
+// compares the point count with uniform 100-step sampling of every curve.
+// Each polyline is checked against dense samples of its contour, and the
+// largest distance found is reported next to the tolerance. Usage:
+//
+//     tools/flatten [--em pixels] [--tolerance pixels] [font files...]
+//
+// The defaults are a 64 pixel EM and a quarter-pixel tolerance.
+// ==========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "Flattener.h"
+
+using namespace std;
+
+// distance from a point to the closest edge of a polyline
+static float Distance(float x, float y, const float *points, unsigned int count)
+{
+    float best = INFINITY;
+    for (unsigned int i = 0; i + 1 < count; ++i)
+    {
+        float ax = points[2*i], ay = points[2*i + 1];
+        float dx = points[2*i + 2] - ax, dy = points[2*i + 3] - ay;
+        float length2 = dx * dx + dy * dy;
+        float u = length2 > 0.f ? ((x - ax) * dx + (y - ay) * dy) / length2 : 0.f;
+        u = min(max(u, 0.f), 1.f);
+        best = min(best, hypotf(ax + u * dx - x, ay + u * dy - y));
+    }
+    return best;
+}
+
+// largest distance from 64 samples per segment of a glyph to its polylines
+static float MaxDeviation(const MyGlyph &glyph, const Polylines &polylines)
+{
+    float worst = 0.f;
+    size_t line = 0;
+    for (size_t c = 0; c < glyph.contours.size(); ++c)
+    {
+        const MyContour &contour = glyph.contours[c];
+        bool drawable = false;
+        for (size_t s = 0; s < contour.size(); ++s)
+            drawable = drawable || (contour[s].degree >= 1 && contour[s].degree <= 3);
+        if (!drawable) continue;
+
+        const float *points = &polylines.points[2 * polylines.starts[line]];
+        unsigned int count = polylines.starts[line + 1] - polylines.starts[line];
+        ++line;
+
+        for (size_t s = 0; s < contour.size(); ++s)
+        {
+            const MySegment &segment = contour[s];
+            if (segment.degree < 1 || segment.degree > 3) continue;
+            float patch[8];
+            for (unsigned int v = 0; v < 4; ++v) {
+                patch[2*v]     = segment.x[min(v, segment.degree)];
+                patch[2*v + 1] = segment.y[min(v, segment.degree)];
+            }
+            for (int k = 0; k <= 64; ++k) {
+                float x, y;
+                PatchTessellator::Evaluate(patch, segment.degree, k / 64.f, x, y);
+                worst = max(worst, Distance(x, y, points, count));
+            }
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char *argv[])
+{
+    float em = 64.f, pixelTolerance = 0.25f;
+    vector<string> fonts;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--em") && i + 1 < argc)
+            em = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+            pixelTolerance = atof(argv[++i]);
+        else
+            fonts.push_back(argv[i]);
+    }
+    if (fonts.empty()) {
+        fonts.push_back("Fonts/Lora-Regular.ttf");
+        fonts.push_back("Fonts/Comic_Sans.ttf");
+        fonts.push_back("Fonts/SourceSansPro-Regular.otf");
+    }
+
+    // outlines are in EM units, so the tolerance is scaled to match
+    float tolerance = pixelTolerance / em;
+    cout << "EM " << em << " px, tolerance " << pixelTolerance << " px" << endl;
+
+    for (size_t f = 0; f < fonts.size(); ++f)
+    {
+        GlyphExtractor extractor;
+        if (!extractor.LoadFontFile(fonts[f])) continue;
+
+        vector<int> characters = extractor.CharacterSet();
+        vector<MyGlyph> glyphs;
+        size_t uniform = 0;
+        for (size_t i = 0; i < characters.size(); ++i)
+        {
+            glyphs.push_back(extractor.ExtractGlyph(characters[i]));
+            const MyGlyph &glyph = glyphs.back();
+            for (size_t c = 0; c < glyph.contours.size(); ++c)
+                for (size_t s = 0; s < glyph.contours[c].size(); ++s) {
+                    unsigned int degree = glyph.contours[c][s].degree;
+                    uniform += degree == 1 ? 1 : degree <= 3 ? 100 : 0;
+                }
+        }
+
+        // the buffers are reused across glyphs and passes, as a caller would
+        Polylines polylines;
+        size_t points = 0;
+        double best = 0.0;
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            points = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (size_t i = 0; i < glyphs.size(); ++i) {
+                Flattener::Flatten(glyphs[i], tolerance, polylines);
+                points += polylines.PointCount() - polylines.Count();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (pass == 0 || seconds < best) best = seconds;
+        }
+
+        float deviation = 0.f;
+        for (size_t i = 0; i < glyphs.size(); ++i) {
+            Flattener::Flatten(glyphs[i], tolerance, polylines);
+            deviation = max(deviation, MaxDeviation(glyphs[i], polylines));
+        }
+
+        cout << fonts[f] << ": " << glyphs.size() << " glyphs, " << points << " segments ("
+             << uniform << " uniform, " << fixed << setprecision(1)
+             << 100.0 * points / max(uniform, size_t(1)) << "%) in " << setprecision(2)
+             << best * 1000.0 << " ms, max deviation " << setprecision(3)
+             << deviation * em << " px" << endl;
+        cout.unsetf(ios::floatfield);
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// ==========================================================================
+// Glyph bank compiler
+//
+// Converts a font file into a precompiled glyph bank (see GlyphBank.h) that
+// the main program can map at startup instead of decoding with FreeType.
+// Usage:
+//
+//     tools/make_glyphbank <font file> <bank file> [characters]
+//
+// Without a character list every character the font maps is included, along
+// with the kerning between every pair of included characters that the font
+// kerns.
+// ==========================================================================
+
+#include <chrono>
+#include <iostream>
+#include "GlyphBank.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        cout << "usage: " << argv[0] << " <font file> <bank file> [characters]" << endl;
+        return 1;
+    }
+
+    GlyphExtractor extractor;
+    if (!extractor.LoadFontFile(argv[1])) return 1;
+
+    vector<int> characters;
+    if (argc > 3) {
+        for (const char *c = argv[3]; *c; ++c)
+            characters.push_back(static_cast<unsigned char>(*c));
+    }
+    else
+        characters = extractor.CharacterSet();
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!GlyphBank::Write(argv[2], extractor, characters)) return 1;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // read it back to check it and to report the load time
+    start = chrono::steady_clock::now();
+    GlyphBank bank;
+    if (!bank.Open(argv[2])) return 1;
+    double openSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << argv[2] << ": " << bank.GlyphCount() << " glyphs, " << bank.KerningCount()
+         << " kerning pairs, written in "
+         << seconds * 1000.0 << " ms, mapped in " << openSeconds * 1000.0 << " ms" << endl;
+    return 0;
+}
@@ -0,0 +1,178 @@
+// ==========================================================================
+// Glyph triangulation benchmark
+//
+// Triangulates the whole character set of each font (see GlyphMesh.h) at a
+// pixel tolerance for a given EM size, reporting glyphs triangulated per
+// second and the triangles produced. Every glyph is also rasterized twice
+// on the CPU, once from its outline and once from its triangles, at a much
+// finer tolerance, and the pixels that differ by more than 32 of 255 are
+// counted; a mesh that leaves holes or covers counters shows up as whole
+// runs of them. A few single pixels are expected where components overlap,
+// since the outline rasterizer clamps summed coverage there while the mesh
+// covers the exact union. Last, a long string is built into instanced
+// geometry through a GlyphMeshCache, cold and then warm, to show the cost
+// once every mesh is cached. Usage:
+//
+//     tools/mesh_bench [--em pixels] [--tolerance pixels] [font files...]
+//
+// The defaults are a 64 pixel EM and a quarter-pixel tolerance.
+// ==========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "GlyphMesh.h"
+#include "Rasterizer.h"
+
+using namespace std;
+
+// pixels that differ noticeably between a glyph filled from its outline and
+// from its triangles, in a canvas two EMs square with the glyph near the middle
+static int CoverageDifference(const MyGlyphView &glyph, const vector<float> &triangles, float em)
+{
+    int size = int(2.f * em);
+    float xTrans = -0.5f, yTrans = -0.3f;
+    Framebuffer outline(size, size), mesh(size, size);
+    outline.Clear(0.f, 0.f, 0.f);
+    mesh.Clear(0.f, 0.f, 0.f);
+
+    // one EM is one clip space unit
+    Rasterizer rasterizer;
+    rasterizer.SetTolerance(0.01f);
+    GlyphGeometry geometry;
+    geometry.AppendGlyph(glyph, 1.f, xTrans, yTrans);
+    rasterizer.Begin(outline);
+    rasterizer.Fill(geometry);
+    rasterizer.Resolve(outline, 1.f, 1.f, 1.f);
+
+    // the triangles as closed loops of line segments, all wound one way
+    vector<float> lines;
+    for (size_t t = 0; t + 6 <= triangles.size(); t += 6)
+    {
+        float x[3], y[3];
+        for (int v = 0; v < 3; ++v) {
+            x[v] = triangles[t + 2*v] + xTrans;
+            y[v] = triangles[t + 2*v + 1] + yTrans;
+        }
+        if ((x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]) < 0.f) {
+            swap(x[1], x[2]);
+            swap(y[1], y[2]);
+        }
+        for (int v = 0; v < 3; ++v) {
+            float segment[4] = { x[v], y[v], x[(v + 1) % 3], y[(v + 1) % 3] };
+            lines.insert(lines.end(), segment, segment + 4);
+        }
+    }
+    rasterizer.Begin(mesh);
+    if (!lines.empty()) rasterizer.FillStream(&lines[0], lines.size() / 2, 1);
+    rasterizer.Resolve(mesh, 1.f, 1.f, 1.f);
+
+    int differing = 0;
+    for (size_t i = 0; i < outline.pixels.size(); i += 4)
+        differing += abs(int(outline.pixels[i]) - int(mesh.pixels[i])) > 32;
+    return differing;
+}
+
+int main(int argc, char *argv[])
+{
+    float em = 64.f, pixelTolerance = 0.25f;
+    vector<string> fonts;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--em") && i + 1 < argc)
+            em = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+            pixelTolerance = atof(argv[++i]);
+        else
+            fonts.push_back(argv[i]);
+    }
+    if (fonts.empty()) {
+        fonts.push_back("Fonts/Lora-Regular.ttf");
+        fonts.push_back("Fonts/Comic_Sans.ttf");
+        fonts.push_back("Fonts/SourceSansPro-Regular.otf");
+        fonts.push_back("Fonts/AlexBrush-Regular.ttf");
+    }
+
+    // outlines are in EM units, so the tolerance is scaled to match
+    float tolerance = pixelTolerance / em;
+    cout << "EM " << em << " px, tolerance " << pixelTolerance << " px" << endl;
+
+    const string pangram = "Sphinx of black quartz, judge my vow! The quick brown fox "
+                           "jumps over the lazy dog. 0123456789 ";
+    string text;
+    for (int i = 0; i < 100; ++i) text += pangram;
+
+    for (size_t f = 0; f < fonts.size(); ++f)
+    {
+        GlyphExtractor extractor;
+        if (!extractor.LoadFontFile(fonts[f])) continue;
+
+        vector<int> characters = extractor.CharacterSet();
+        vector<MyGlyph> glyphs;
+        for (size_t i = 0; i < characters.size(); ++i)
+            glyphs.push_back(extractor.ExtractGlyph(characters[i]));
+
+        // the triangulator and output are reused, as the cache does
+        Triangulator triangulator;
+        vector<float> triangles;
+        size_t triangleCount = 0;
+        double best = 0.0;
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            triangleCount = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (size_t i = 0; i < glyphs.size(); ++i) {
+                triangulator.Triangulate(glyphs[i], tolerance, triangles);
+                triangleCount += triangles.size() / 6;
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (pass == 0 || seconds < best) best = seconds;
+        }
+
+        int differing = 0, worst = 0, worstCharacter = 0;
+        MyPackedGlyph packed;
+        for (size_t i = 0; i < characters.size(); ++i)
+        {
+            MyGlyphView view = extractor.ExtractGlyph(characters[i], packed);
+            triangulator.Triangulate(view, 0.01f / em, triangles);
+            int difference = CoverageDifference(view, triangles, em);
+            differing += difference;
+            if (difference > worst) {
+                worst = difference;
+                worstCharacter = characters[i];
+            }
+        }
+
+        // a long string through the mesh cache, cold then warm
+        MyGlyphRun run;
+        extractor.ExtractString(text, run);
+        GlyphMeshCache cache;
+        InstancedGlyphGeometry instanced;
+        instanced.SetMeshCache(&cache, tolerance);
+        double build[2];
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            instanced.Clear();
+            instanced.AppendRun(run, 1.f, 0.f, 0.f);
+            instanced.Finish();
+            build[pass] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+
+        cout << fonts[f] << ": " << glyphs.size() << " glyphs, " << triangleCount
+             << " triangles in " << fixed << setprecision(2) << best * 1000.0 << " ms ("
+             << setprecision(0) << glyphs.size() / best << " glyphs/s), " << differing
+             << " pixels differ";
+        if (worst > 0) cout << " (at most " << worst << ", character " << worstCharacter << ")";
+        cout << endl << "  " << text.size() << " characters, " << cache.Size()
+             << " meshes: " << setprecision(2) << build[0] * 1000.0 << " ms cold, "
+             << build[1] * 1000.0 << " ms cached, " << instanced.Vertices(InstancedGlyphGeometry::TRIANGLES) / 3
+             << " triangles drawn with " << instanced.Draws(InstancedGlyphGeometry::TRIANGLES).size()
+             << " instanced draws" << endl;
+        cout.unsetf(ios::floatfield);
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+// ==========================================================================
+// Tiled rasterizer scaling benchmark
+//
+// Builds a specimen sheet (lines of text set in each font in turn, filling a
+// large square canvas) and fills it with the single-threaded Rasterizer and
+// with the TiledRasterizer at 1, 2, 4 and N threads (N = hardware threads),
+// reporting megapixels and edges per second, the speedup over one tiled
+// thread, and the largest difference from the single-threaded image. Usage:
+//
+//     tools/raster_bench [--size pixels] [--em pixels] [--write file.png]
+//                        [font files...]     (defaults to a few in Fonts/)
+//
+// The defaults are an 8192 x 8192 canvas with a 64 pixel EM.
+// ==========================================================================
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "TiledRasterizer.h"
+
+using namespace std;
+
+// best of several timed passes of a rasterizer over the sheet, in seconds
+template <class Renderer>
+static double TimeSheet(Renderer &renderer, const GlyphGeometry &sheet, Framebuffer &image)
+{
+    double best = 0.0;
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        image.Clear(1.f, 1.f, 1.f);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        renderer.Begin(image);
+        renderer.Fill(sheet);
+        renderer.Resolve(image, 0.f, 0.f, 0.f);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int size = 8192;
+    float em = 64.f;
+    string writeFile;
+    vector<string> fonts;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc)
+            size = max(64, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--em") && i + 1 < argc)
+            em = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--write") && i + 1 < argc)
+            writeFile = argv[++i];
+        else
+            fonts.push_back(argv[i]);
+    }
+    if (fonts.empty()) {
+        fonts.push_back("Fonts/Lora-Regular.ttf");
+        fonts.push_back("Fonts/Comic_Sans.ttf");
+        fonts.push_back("Fonts/SourceSansPro-Regular.otf");
+        fonts.push_back("Fonts/AlexBrush-Regular.ttf");
+    }
+
+    // lines of text down the canvas, cycling through the fonts; positions
+    // are in clip space, so one EM is 2 em / size clip units
+    const string pangram = "Sphinx of black quartz, judge my vow! The quick brown fox "
+                           "jumps over the lazy dog. 0123456789 ";
+    float scale = 2.f * em / size, lineHeight = 1.3f * scale;
+    vector<unique_ptr<GlyphExtractor> > extractors;
+    for (size_t f = 0; f < fonts.size(); ++f) {
+        extractors.push_back(unique_ptr<GlyphExtractor>(new GlyphExtractor));
+        if (!extractors.back()->LoadFontFile(fonts[f])) return 1;
+    }
+
+    GlyphGeometry sheet;
+    MyGlyphRun run;
+    string text;
+    while (text.size() * 0.5f * em < size) text += pangram;
+    int lines = 0;
+    for (float y = 1.f - lineHeight; y > -1.f; y -= lineHeight, ++lines) {
+        extractors[lines % extractors.size()]->ExtractString(text, run);
+        sheet.AppendRun(run, scale, -1.f / scale + 0.25f, y / scale);
+    }
+
+    Framebuffer reference(size, size), image(size, size);
+    double megapixels = double(size) * size / 1e6;
+    cout << size << "x" << size << " canvas, " << lines << " lines of " << text.size()
+         << " characters" << endl;
+
+    Rasterizer single;
+    double seconds = TimeSheet(single, sheet, reference);
+    cout << fixed << setprecision(1) << "  Rasterizer          " << setw(8) << seconds * 1000.0
+         << " ms  " << setw(7) << megapixels / seconds << " MP/s" << endl;
+
+    vector<unsigned int> threadCounts;
+    threadCounts.push_back(1);
+    threadCounts.push_back(2);
+    threadCounts.push_back(4);
+    unsigned int hardware = thread::hardware_concurrency();
+    if (hardware > 4) threadCounts.push_back(hardware);
+
+    double baseline = 0.0;
+    for (size_t t = 0; t < threadCounts.size(); ++t)
+    {
+        TiledRasterizer tiled(threadCounts[t]);
+        seconds = TimeSheet(tiled, sheet, image);
+        if (t == 0) baseline = seconds;
+        cout << "  tiled, " << setw(2) << threadCounts[t] << " threads   " << setw(8)
+             << seconds * 1000.0 << " ms  " << setw(7) << megapixels / seconds << " MP/s  "
+             << setw(6) << tiled.EdgeCount() / seconds / 1e6 << " M edges/s  " << setprecision(2)
+             << baseline / seconds << "x  " << tiled.BinnedCount() << " binned, "
+             << tiled.Steals() << " steals, max difference "
+             << Framebuffer::MaxDifference(image, reference) << endl;
+        cout << setprecision(1);
+    }
+
+    if (!writeFile.empty() && !image.WritePNG(writeFile)) return 1;
+    return 0;
+}
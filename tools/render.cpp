@@ -0,0 +1,115 @@
+// ==========================================================================
+// Headless text rendering to PNG
+//
+// Lays out a string, builds its patch geometry as the text scenes do and
+// renders it with the software rasterizer (see Rasterizer.h): outlines are
+// stroked in white on black like the scenes, or filled. Usage:
+//
+//     tools/render <font file> <text> <output.png> [options]
+//
+//     --size <width> <height>  framebuffer size (default 1024 1024)
+//     --place <scale> <x> <y>  placement as in the scenes (0.5 -2 -0.39)
+//     --tracking <em>          added after every advance (default 0)
+//     --fill                   fills the glyphs instead of stroking them
+//     --width <pixels>         stroke width (default 1)
+//     --check <file>           compares with a golden image and fails if
+//                              any channel differs by more than --max-diff
+//     --max-diff <value>       comparison tolerance (default 2)
+// ==========================================================================
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "Rasterizer.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        cout << "usage: " << argv[0] << " <font file> <text> <output.png> [--size w h]"
+             << " [--place scale x y] [--tracking em] [--fill] [--width pixels]"
+             << " [--check file] [--max-diff value]" << endl;
+        return 1;
+    }
+
+    int width = 1024, height = 1024, maxDiff = 2;
+    float scale = 0.5f, xTrans = -2.f, yTrans = -0.39f, tracking = 0.f, strokeWidth = 1.f;
+    bool fill = false;
+    string checkFile;
+    for (int i = 4; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--size") && i + 2 < argc) {
+            width = atoi(argv[++i]);
+            height = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--place") && i + 3 < argc) {
+            scale = atof(argv[++i]);
+            xTrans = atof(argv[++i]);
+            yTrans = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--tracking") && i + 1 < argc)
+            tracking = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--fill"))
+            fill = true;
+        else if (!strcmp(argv[i], "--width") && i + 1 < argc)
+            strokeWidth = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--check") && i + 1 < argc)
+            checkFile = argv[++i];
+        else if (!strcmp(argv[i], "--max-diff") && i + 1 < argc)
+            maxDiff = atoi(argv[++i]);
+        else {
+            cout << "unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (width <= 0 || height <= 0) {
+        cout << "invalid size " << width << "x" << height << endl;
+        return 1;
+    }
+
+    GlyphExtractor extractor;
+    if (!extractor.LoadFontFile(argv[1])) return 1;
+
+    MyGlyphRun run;
+    GlyphGeometry geometry;
+    extractor.ExtractString(argv[2], run, tracking);
+    geometry.AppendRun(run, scale, xTrans, yTrans);
+
+    Framebuffer image(width, height);
+    Rasterizer rasterizer;
+
+    // best of several passes, so the figure is not dominated by first-touch
+    double best = 0.0;
+    for (int pass = 0; pass < 5; ++pass)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        image.Clear(0.f, 0.f, 0.f);
+        rasterizer.Begin(image);
+        if (fill)
+            rasterizer.Fill(geometry);
+        else
+            rasterizer.Stroke(geometry, strokeWidth);
+        rasterizer.Resolve(image, 1.f, 1.f, 1.f);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+
+    cout << run.Size() << " glyphs rendered at " << width << "x" << height << " in "
+         << best * 1000.0 << " ms" << endl;
+    if (!image.WritePNG(argv[3])) return 1;
+
+    if (!checkFile.empty())
+    {
+        Framebuffer golden;
+        if (!golden.ReadPNG(checkFile)) return 1;
+        int difference = Framebuffer::MaxDifference(image, golden);
+        if (difference > maxDiff) {
+            cout << "FAIL: differs from " << checkFile << " by up to " << difference << endl;
+            return 1;
+        }
+        cout << "OK: matches " << checkFile << " (largest difference " << difference << ")" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+// ==========================================================================
+// Signed distance field atlas generator
+//
+// Builds an SDF atlas (see SDFAtlas.h) for each font, from the printable
+// ASCII characters or with --all from every character the font maps, and
+// writes it next to its metrics as <out>/<font>.sdf.png and .sdf.txt.
+// Reports the atlas size, its raw and PNG bytes, and the best of three
+// generation times, in total and per glyph. With --check every glyph is
+// also compared with a reference field measured from the outline
+// flattened to within 1e-4 EM, brute force over the line segments with the
+// nonzero sign from a ray cast, and the largest difference is reported in
+// pixels. Usage:
+//
+//     tools/sdf_atlas [--em pixels] [--range pixels] [--threads n] [--all]
+//                     [--out directory] [--check] font files...
+//
+// e.g. tools/sdf_atlas Fonts/*.ttf Fonts/*.otf. The defaults are a 32 pixel
+// EM, a 4 pixel range, one thread per hardware thread and the current
+// directory.
+// ==========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "Flattener.h"
+#include "SDFAtlas.h"
+
+using namespace std;
+
+// largest difference in pixels between a glyph's atlas field and the field
+// of its finely flattened outline
+static double CheckGlyph(const SDFAtlas &atlas, const SDFGlyph &entry, const MyGlyph &glyph)
+{
+    Polylines contours;
+    Flattener::Flatten(glyph, 1e-4f, contours);
+    const vector<float> &p = contours.points;
+    double em = atlas.PixelsPerEM(), range = atlas.Range(), worst = 0.0;
+
+    for (int row = 0; row < entry.height; ++row)
+        for (int column = 0; column < entry.width; ++column)
+        {
+            double px = entry.left + (column + 0.5) / em;
+            double py = entry.top - (row + 0.5) / em;
+            double best = HUGE_VAL;
+            int winding = 0;
+            for (size_t c = 0; c < contours.Count(); ++c)
+                for (unsigned int i = contours.starts[c]; i < contours.starts[c + 1]; ++i)
+                {
+                    // the last edge closes the polyline, in case the font left it open
+                    unsigned int j = i + 1 < contours.starts[c + 1] ? i + 1 : contours.starts[c];
+                    double x0 = p[2*i], y0 = p[2*i + 1], x1 = p[2*j], y1 = p[2*j + 1];
+                    double dx = x1 - x0, dy = y1 - y0, length = dx * dx + dy * dy;
+                    double t = length > 0.0 ? ((px - x0) * dx + (py - y0) * dy) / length : 0.0;
+                    t = min(1.0, max(0.0, t));
+                    double cx = x0 + t * dx - px, cy = y0 + t * dy - py;
+                    best = min(best, cx * cx + cy * cy);
+                    if ((y0 <= py) != (y1 <= py) && x0 + (py - y0) * dx / dy > px)
+                        winding += y1 > y0 ? 1 : -1;
+                }
+
+            double distance = sqrt(best) * em;
+            double reference = max(-range, min(range, winding != 0 ? distance : -distance));
+            double value = atlas.Pixels()[size_t(entry.y + row) * atlas.Width() + entry.x + column];
+            worst = max(worst, fabs((value / 127.5 - 1.0) * range - reference));
+        }
+    return worst;
+}
+
+int main(int argc, char *argv[])
+{
+    float em = 32.f, range = 4.f;
+    unsigned int threads = 0;
+    bool all = false, check = false;
+    string directory = ".";
+    vector<string> fonts;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--em") && i + 1 < argc)
+            em = max(1.f, float(atof(argv[++i])));
+        else if (!strcmp(argv[i], "--range") && i + 1 < argc)
+            range = max(0.5f, float(atof(argv[++i])));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            directory = argv[++i];
+        else if (!strcmp(argv[i], "--all"))
+            all = true;
+        else if (!strcmp(argv[i], "--check"))
+            check = true;
+        else
+            fonts.push_back(argv[i]);
+    }
+    if (fonts.empty()) {
+        cout << "usage: tools/sdf_atlas [--em pixels] [--range pixels] [--threads n] [--all]" << endl
+             << "                       [--out directory] [--check] font files..." << endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    cout << em << " pixels per EM, range " << range << " pixels, " << pool.ThreadCount()
+         << " threads" << endl;
+
+    size_t totalGlyphs = 0, totalBytes = 0, totalFileBytes = 0;
+    double totalSeconds = 0.0;
+    for (size_t f = 0; f < fonts.size(); ++f)
+    {
+        GlyphExtractor extractor;
+        if (!extractor.LoadFontFile(fonts[f])) return 1;
+
+        // the extractor is not thread-safe, so outlines are copied out first
+        vector<int> characters, set = extractor.CharacterSet();
+        vector<MyGlyph> glyphs;
+        for (size_t i = 0; i < set.size(); ++i)
+            if (all || (set[i] >= 32 && set[i] < 127)) {
+                characters.push_back(set[i]);
+                glyphs.push_back(extractor.ExtractGlyph(set[i]));
+            }
+        if (glyphs.empty()) continue;
+
+        SDFAtlas atlas(em, range);
+        double seconds = 0.0;
+        unsigned long steals = pool.Steals();
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            atlas.Build(&characters[0], &glyphs[0], glyphs.size(), pool);
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (pass == 0 || elapsed < seconds) seconds = elapsed;
+        }
+        steals = pool.Steals() - steals;
+
+        string name = fonts[f].substr(fonts[f].find_last_of('/') + 1);
+        name = directory + "/" + name.substr(0, name.find_last_of('.')) + ".sdf";
+        if (!atlas.WritePNG(name + ".png") || !atlas.WriteMetrics(name + ".txt")) return 1;
+        long fileBytes = 0;
+        if (FILE *file = fopen((name + ".png").c_str(), "rb")) {
+            fseek(file, 0, SEEK_END);
+            fileBytes = ftell(file);
+            fclose(file);
+        }
+
+        cout << fonts[f] << ": " << glyphs.size() << " glyphs, " << atlas.Width() << "x"
+             << atlas.Height() << ", " << atlas.Bytes() << " bytes (" << fileBytes << " as PNG), "
+             << fixed << setprecision(2) << seconds * 1000.0 << " ms, " << setprecision(1)
+             << seconds * 1e6 / glyphs.size() << " us per glyph, " << steals << " steals" << endl;
+        cout.unsetf(ios::fixed);
+        totalGlyphs += glyphs.size();
+        totalBytes += atlas.Bytes();
+        totalFileBytes += fileBytes;
+        totalSeconds += seconds;
+
+        if (check) {
+            double worst = 0.0;
+            for (size_t i = 0; i < glyphs.size(); ++i)
+                if (atlas.Glyphs()[i].width > 0)
+                    worst = max(worst, CheckGlyph(atlas, atlas.Glyphs()[i], glyphs[i]));
+            cout << "  largest difference from the flattened outline " << fixed << setprecision(3)
+                 << worst << " pixels" << endl;
+            cout.unsetf(ios::fixed);
+        }
+    }
+
+    if (fonts.size() > 1 && totalGlyphs > 0)
+        cout << "total: " << totalGlyphs << " glyphs, " << totalBytes << " bytes (" << totalFileBytes
+             << " as PNG), " << fixed << setprecision(2) << totalSeconds * 1000.0 << " ms, "
+             << setprecision(1) << totalSeconds * 1e6 / totalGlyphs << " us per glyph" << endl;
+    return 0;
+}
@@ -0,0 +1,109 @@
+// ==========================================================================
+// Headless tessellation and verification
+//
+// Lays out a string, builds its patch geometry as the text scenes do and
+// tessellates it with the CPU reference tessellator (see Tessellator.h).
+// Usage:
+//
+//     tools/tessellate <font file> <text> [options]
+//
+//     --fixed <level>        fixed tessellation level instead of adaptive
+//     --tolerance <pixels>   adaptive pixel tolerance (default 0.25)
+//     --place <scale> <x> <y>  placement as in the scenes (0.5 -2 -0.39)
+//     --write <file>         saves the polylines, e.g. as a reference
+//     --check <file>         compares against a reference and fails if any
+//                            coordinate differs by more than --epsilon
+//
+// The reference is a regression snapshot saved with --write by this same
+// tessellator, not output captured from the GPU, so --check catches changes
+// in the geometry or the CPU tessellator only.
+//     --epsilon <value>      comparison tolerance (default 1e-4)
+// ==========================================================================
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "Tessellator.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        cout << "usage: " << argv[0] << " <font file> <text> [--fixed level] [--tolerance pixels]"
+             << " [--place scale x y] [--write file] [--check file] [--epsilon value]" << endl;
+        return 1;
+    }
+
+    TessellationSettings settings;
+    float scale = 0.5f, xTrans = -2.f, yTrans = -0.39f, epsilon = 1e-4f;
+    string writeFile, checkFile;
+    for (int i = 3; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--fixed") && i + 1 < argc) {
+            settings.adaptive = false;
+            settings.fixedLevel = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+            settings.pixelTolerance = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--place") && i + 3 < argc) {
+            scale = atof(argv[++i]);
+            xTrans = atof(argv[++i]);
+            yTrans = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--write") && i + 1 < argc)
+            writeFile = argv[++i];
+        else if (!strcmp(argv[i], "--check") && i + 1 < argc)
+            checkFile = argv[++i];
+        else if (!strcmp(argv[i], "--epsilon") && i + 1 < argc)
+            epsilon = atof(argv[++i]);
+        else {
+            cout << "unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    GlyphExtractor extractor;
+    if (!extractor.LoadFontFile(argv[1])) return 1;
+
+    MyGlyphRun run;
+    GlyphGeometry geometry;
+    extractor.ExtractString(argv[2], run);
+    geometry.AppendRun(run, scale, xTrans, yTrans);
+
+    // best of several passes, so the figure is not dominated by first-touch
+    Polylines polylines;
+    double best = 0.0;
+    for (int pass = 0; pass < 5; ++pass)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        PatchTessellator::Tessellate(geometry, settings, polylines);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+
+    cout << polylines.Count() << " polylines, " << polylines.PointCount() << " points, "
+         << polylines.PointCount() - polylines.Count() << " segments in "
+         << best * 1000.0 << " ms" << endl;
+
+    if (!writeFile.empty() && !polylines.Write(writeFile)) return 1;
+
+    if (!checkFile.empty())
+    {
+        Polylines reference;
+        if (!reference.Read(checkFile)) return 1;
+        float error;
+        if (!Polylines::Compare(polylines, reference, epsilon, &error)) {
+            if (polylines.starts != reference.starts)
+                cout << "FAIL: output differs in shape from " << checkFile << " ("
+                     << reference.Count() << " polylines, " << reference.PointCount() << " points)" << endl;
+            else
+                cout << "FAIL: largest difference " << error << " exceeds " << epsilon << endl;
+            return 1;
+        }
+        cout << "OK: matches " << checkFile << " within " << epsilon
+             << " (largest difference " << error << ")" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// ==========================================================================
+// Zoom benchmark for the flattened outline cache
+//
+// Lays out a string and replays a zoom animation over it: each frame sets an
+// EM size that sweeps from 16 to 512 pixels and back, and fetches the
+// flattened outline of every glyph at a quarter-pixel tolerance, either by
+// flattening it again or through a PolylineCache (see PolylineCache.h).
+// Reports the time per frame, hit rate, memory use and evictions for a few
+// budgets. Usage:
+//
+//     tools/zoom_bench <font file> [text] [--frames n]
+// ==========================================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "PolylineCache.h"
+
+using namespace std;
+
+// EM size in pixels at a frame of the sweep
+static float FrameEM(int frame, int frames)
+{
+    float t = float(frame % frames) / frames;
+    float sweep = t < 0.5f ? 2.f * t : 2.f - 2.f * t;
+    return 16.f * pow(32.f, sweep);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        cout << "usage: " << argv[0] << " <font file> [text] [--frames n]" << endl;
+        return 1;
+    }
+
+    string text = "The quick brown fox jumps over the lazy dog. Sphinx of black quartz, judge my vow!";
+    int frames = 240;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = max(1, atoi(argv[++i]));
+        else
+            text = argv[i];
+    }
+
+    GlyphExtractor extractor;
+    if (!extractor.LoadFontFile(argv[1])) return 1;
+    MyGlyphRun run;
+    extractor.ExtractString(text, run);
+    FontHandle font = extractor.ActiveFont();
+
+    // uncached: every glyph flattened again every frame
+    Polylines polylines;
+    size_t points = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        float tolerance = PolylineCache::ToleranceFor(FrameEM(frame, frames));
+        for (size_t i = 0; i < run.Size(); ++i) {
+            Flattener::Flatten(run.Outline(i), tolerance, polylines);
+            points += polylines.PointCount();
+        }
+    }
+    double uncached = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << run.Size() << " glyphs (" << run.uniqueCount << " distinct), " << frames
+         << " frames, EM 16-512 px" << endl;
+    cout << fixed << setprecision(1) << "  uncached           " << setw(7)
+         << uncached * 1e6 / frames << " us/frame, " << points / frames << " points/frame" << endl;
+
+    size_t budgets[] = { 16 << 10, 64 << 10, 256 << 10, 4 << 20 };
+    for (int b = 0; b < 4; ++b)
+    {
+        PolylineCache cache(budgets[b]);
+        start = chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            float tolerance = PolylineCache::ToleranceFor(FrameEM(frame, frames));
+            for (size_t i = 0; i < run.Size(); ++i)
+                cache.Flatten(font, run.glyphs[i].character, run.Outline(i), tolerance);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "  budget " << setw(5) << (budgets[b] >> 10) << " KB   " << setw(7)
+             << seconds * 1e6 / frames << " us/frame, hit rate " << setprecision(2)
+             << cache.HitRate() * 100.0 << "%, " << cache.Size() << " entries in "
+             << setprecision(1) << cache.Bytes() / 1024.0 << " KB, " << cache.Evictions()
+             << " evictions" << endl;
+    }
+    return 0;
+}
@@ -11,6 +11,10 @@
 layout(location = 0) in vec2 VertexPosition;
 layout(location = 1) in vec3 VertexColour;
 
+// per-instance placement of instanced glyphs: the vertex is drawn at
+// (VertexPosition + xy) * z; non-instanced geometry leaves it at (0, 0, 1)
+layout(location = 2) in vec3 InstanceTransform;
+
 // output to be interpolated between vertices and passed to the fragment stage
 out vec3 tcColour;
 
@@ -20,16 +24,17 @@ uniform float scrollFactor;
 
 void main()
 {
-	vec2 newPos = VertexPosition;
+	vec2 position = (VertexPosition + InstanceTransform.xy) * InstanceTransform.z;
+	vec2 newPos = position;
 	if (scroll){
 		if (!awesome){
-			float xPos = VertexPosition.x + scrollFactor;
-			float yPos = VertexPosition.y;
+			float xPos = position.x + scrollFactor;
+			float yPos = position.y;
 			newPos = vec2(xPos, yPos);
 		} else {
-			float xPos = VertexPosition.x + scrollFactor;
+			float xPos = position.x + scrollFactor;
 			float yPos = (xPos + 1.f) / 2.f;
-			newPos = vec2(xPos, VertexPosition.y / yPos);
+			newPos = vec2(xPos, position.y / yPos);
 		}
 	}
     // assign vertex position without modification
@@ -11,6 +11,10 @@
 layout(location = 0) in vec2 VertexPosition;
 layout(location = 1) in vec3 VertexColour;
 
+// per-instance placement of instanced glyphs: the vertex is drawn at
+// (VertexPosition + xy) * z; non-instanced geometry leaves it at (0, 0, 1)
+layout(location = 2) in vec3 InstanceTransform;
+
 // output to be interpolated between vertices and passed to the fragment stage
 out vec3 tcColour;
 
@@ -19,11 +23,12 @@ uniform float scrollFactor;
 
 void main()
 {
-	vec2 newPos = VertexPosition;
+	vec2 position = (VertexPosition + InstanceTransform.xy) * InstanceTransform.z;
+	vec2 newPos = position;
 	if (scroll){
-		float xPos = VertexPosition.x + scrollFactor;
-		float yPos = VertexPosition.x;
-		newPos = vec2((VertexPosition.x - 2.f / -xPos) + (scrollFactor / 5), (VertexPosition.y * yPos));
+		float xPos = position.x + scrollFactor;
+		float yPos = position.x;
+		newPos = vec2((position.x - 2.f / -xPos) + (scrollFactor / 5), (position.y * yPos));
 	}
     // assign vertex position without modification
     gl_Position = vec4(newPos, 0.0, 1.0);